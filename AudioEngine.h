@@ -0,0 +1,154 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "SpscQueue.h"
+
+// Request from the game thread to start a sample.
+struct AudioCommand {
+    int sample;
+    float volume;
+    float pan;     // -1 left .. 1 right
+    Uint64 sentAt; // SDL_GetPerformanceCounter() when play() was called
+};
+
+// Mixer running in the SDL audio callback. Samples are mono float PCM, all
+// added before open(); a fixed pool of voices plays them. The game thread only
+// talks to the callback through a lock-free single-producer/single-consumer
+// command queue, so neither side takes a lock or allocates once running. When
+// the queue is full the command is dropped; when every voice is busy the
+// oldest one is cut off.
+class AudioEngine {
+public:
+    static const int SAMPLE_RATE = 48000;
+    static const int MAX_VOICES = 16;
+    static const int QUEUE_SIZE = 256;
+
+    // Totals since open(). Callback times and latencies are performance
+    // counter ticks; the maxima are reset by whoever reads them.
+    std::atomic<long> callbacks{ 0 };
+    std::atomic<long> started{ 0 };
+    std::atomic<long> stolenVoices{ 0 };
+    std::atomic<long> droppedCommands{ 0 };
+    std::atomic<Uint64> callbackTicks{ 0 }, maxCallbackTicks{ 0 };
+    std::atomic<Uint64> latencyTicks{ 0 }, maxLatencyTicks{ 0 };
+
+    ~AudioEngine() { close(); }
+
+    // Returns the id to play it by.
+    int addSample(std::vector<float> pcm) {
+        samples.push_back(std::move(pcm));
+        return (int)samples.size() - 1;
+    }
+
+    bool open(const char* deviceName = nullptr, int bufferFrames = 512) {
+        close();
+        SDL_AudioSpec want = {};
+        want.freq = SAMPLE_RATE;
+        want.format = AUDIO_F32SYS;
+        want.channels = 2;
+        want.samples = (Uint16)bufferFrames;
+        want.callback = callback;
+        want.userdata = this;
+        // No allowed changes: SDL converts if the device wants something else,
+        // so the callback always mixes stereo float at SAMPLE_RATE
+        device = SDL_OpenAudioDevice(deviceName, 0, &want, &spec, 0);
+        if (device == 0) return false;
+        SDL_PauseAudioDevice(device, 0);
+        return true;
+    }
+
+    void close() {
+        if (device == 0) return;
+        SDL_CloseAudioDevice(device);
+        device = 0;
+        for (Voice& v : voices) v.sample = -1;
+        AudioCommand c;
+        while (commands.tryPop(c)) {}
+    }
+
+    bool active() const { return device != 0; }
+
+    // Length of one callback buffer in milliseconds.
+    double bufferMs() const { return active() ? spec.samples * 1000.0 / spec.freq : 0; }
+
+    // Game thread only.
+    void play(int sample, float volume = 1.0f, float pan = 0.0f) {
+        if (device == 0 || sample < 0 || sample >= (int)samples.size()) return;
+        AudioCommand c = { sample, volume, std::min(1.0f, std::max(-1.0f, pan)), SDL_GetPerformanceCounter() };
+        if (!commands.tryPush(c)) droppedCommands++;
+    }
+
+private:
+    struct Voice {
+        int sample = -1; // -1 when free
+        int position = 0;
+        float left = 0, right = 0;
+    };
+
+    std::vector<std::vector<float>> samples;
+    Voice voices[MAX_VOICES];
+    SpscQueue<AudioCommand, QUEUE_SIZE> commands;
+    SDL_AudioDeviceID device = 0;
+    SDL_AudioSpec spec = {};
+
+    static void SDLCALL callback(void* userdata, Uint8* stream, int len) {
+        static_cast<AudioEngine*>(userdata)->mix((float*)stream, len / (int)(2 * sizeof(float)));
+    }
+
+    static void storeMax(std::atomic<Uint64>& max, Uint64 value) {
+        Uint64 seen = max.load(std::memory_order_relaxed);
+        while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    void mix(float* out, int frameCount) {
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        AudioCommand c;
+        while (commands.tryPop(c)) {
+            Uint64 latency = start - c.sentAt;
+            latencyTicks.fetch_add(latency, std::memory_order_relaxed);
+            storeMax(maxLatencyTicks, latency);
+            startVoice(c);
+        }
+
+        std::fill(out, out + frameCount * 2, 0.0f);
+        for (Voice& v : voices) {
+            if (v.sample < 0) continue;
+            const std::vector<float>& pcm = samples[v.sample];
+            int n = std::min(frameCount, (int)pcm.size() - v.position);
+            const float* src = pcm.data() + v.position;
+            for (int i = 0; i < n; i++) {
+                out[i * 2] += src[i] * v.left;
+                out[i * 2 + 1] += src[i] * v.right;
+            }
+            v.position += n;
+            if (v.position >= (int)pcm.size()) v.sample = -1;
+        }
+        for (int i = 0; i < frameCount * 2; i++) out[i] = std::min(1.0f, std::max(-1.0f, out[i]));
+
+        Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+        callbackTicks.fetch_add(elapsed, std::memory_order_relaxed);
+        storeMax(maxCallbackTicks, elapsed);
+        callbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void startVoice(const AudioCommand& c) {
+        Voice* voice = nullptr;
+        for (Voice& v : voices) {
+            if (v.sample < 0) { voice = &v; break; }
+            if (!voice || v.position > voice->position) voice = &v;
+        }
+        if (voice->sample >= 0) stolenVoices.fetch_add(1, std::memory_order_relaxed);
+
+        // Constant power pan
+        float angle = (c.pan + 1) * 0.25f * 3.14159265f;
+        voice->sample = c.sample;
+        voice->position = 0;
+        voice->left = c.volume * std::cos(angle);
+        voice->right = c.volume * std::sin(angle);
+        started.fetch_add(1, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+
+// Non-owning view of `size` contiguous elements.
+template<typename T>
+struct Span {
+    T* data;
+    int size;
+
+    T& operator[](int i) const { return data[i]; }
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+};
+
+// Bump allocator for scratch data that only lives until the end of the frame.
+// reset() rewinds every block without freeing it, so once the first few frames
+// have sized the blocks, allocating from the arena never touches the heap.
+// Only trivially destructible types: nothing is destroyed on reset.
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+
+    template<typename T>
+    Span<T> alloc(int count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena does not run destructors");
+        void* p = allocBytes(sizeof(T) * count, alignof(T));
+        return { static_cast<T*>(p), count };
+    }
+
+    void reset() {
+        for (Block& b : blocks) b.used = 0;
+        current = 0;
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& b : blocks) total += b.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t blockSize;
+
+    void* allocBytes(size_t bytes, size_t align) {
+        while (current < blocks.size()) {
+            Block& b = blocks[current];
+            // Offsets are aligned relative to the block start, which is max-aligned
+            size_t offset = (b.used + align - 1) & ~(align - 1);
+            if (offset + bytes <= b.size) {
+                b.used = offset + bytes;
+                return b.data.get() + offset;
+            }
+            current++;
+        }
+
+        // Out of space: add a block. Only happens while the arena is warming up
+        // or when a frame needs more scratch than any frame before it.
+        // new char[] is aligned for any fundamental type, so offset 0 always fits.
+        Block b;
+        b.size = std::max(blockSize, bytes);
+        b.data.reset(new char[b.size]);
+        b.used = bytes;
+        blocks.push_back(std::move(b));
+        current = blocks.size() - 1;
+        return blocks.back().data.get();
+    }
+};
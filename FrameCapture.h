@@ -0,0 +1,253 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include "SpscQueue.h"
+
+// Largest possible QOI encoding of a w x h RGBA image: header, one 5-byte op
+// per pixel and the end marker.
+inline size_t qoiMaxSize(int w, int h) {
+    return 14 + (size_t)w * h * 5 + 8;
+}
+
+// Encodes RGBA pixels (rows `pitch` bytes apart) as a QOI image, see
+// https://qoiformat.org. `out` must hold qoiMaxSize(w, h) bytes. Returns the
+// number of bytes written.
+inline size_t qoiEncode(const unsigned char* pixels, int w, int h, int pitch, unsigned char* out) {
+    size_t n = 0;
+    auto put32 = [&](unsigned v) {
+        out[n++] = (unsigned char)(v >> 24);
+        out[n++] = (unsigned char)(v >> 16);
+        out[n++] = (unsigned char)(v >> 8);
+        out[n++] = (unsigned char)v;
+    };
+    out[n++] = 'q'; out[n++] = 'o'; out[n++] = 'i'; out[n++] = 'f';
+    put32((unsigned)w);
+    put32((unsigned)h);
+    out[n++] = 4; // RGBA
+    out[n++] = 0; // sRGB with linear alpha
+
+    unsigned char index[64][4] = {};
+    unsigned char prev[4] = { 0, 0, 0, 255 };
+    int run = 0;
+    for (int y = 0; y < h; y++) {
+        const unsigned char* row = pixels + (size_t)y * pitch;
+        for (int x = 0; x < w; x++) {
+            const unsigned char* px = row + x * 4;
+            bool last = y == h - 1 && x == w - 1;
+            if (std::memcmp(px, prev, 4) == 0) {
+                run++;
+                if (run == 62 || last) {
+                    out[n++] = (unsigned char)(0xc0 | (run - 1)); // QOI_OP_RUN
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                out[n++] = (unsigned char)(0xc0 | (run - 1));
+                run = 0;
+            }
+
+            int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+            if (std::memcmp(index[hash], px, 4) == 0) {
+                out[n++] = (unsigned char)hash; // QOI_OP_INDEX
+            }
+            else {
+                std::memcpy(index[hash], px, 4);
+                if (px[3] == prev[3]) {
+                    int dr = (signed char)(px[0] - prev[0]);
+                    int dg = (signed char)(px[1] - prev[1]);
+                    int db = (signed char)(px[2] - prev[2]);
+                    int drg = dr - dg, dbg = db - dg;
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        out[n++] = (unsigned char)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)); // QOI_OP_DIFF
+                    }
+                    else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7) {
+                        out[n++] = (unsigned char)(0x80 | (dg + 32)); // QOI_OP_LUMA
+                        out[n++] = (unsigned char)((drg + 8) << 4 | (dbg + 8));
+                    }
+                    else {
+                        out[n++] = 0xfe; // QOI_OP_RGB
+                        out[n++] = px[0]; out[n++] = px[1]; out[n++] = px[2];
+                    }
+                }
+                else {
+                    out[n++] = 0xff; // QOI_OP_RGBA
+                    out[n++] = px[0]; out[n++] = px[1]; out[n++] = px[2]; out[n++] = px[3];
+                }
+            }
+            std::memcpy(prev, px, 4);
+        }
+    }
+    for (int i = 0; i < 7; i++) out[n++] = 0;
+    out[n++] = 1;
+    return n;
+}
+
+// Records presented frames without slowing the frame loop down. The render
+// thread copies each frame into one of a fixed set of preallocated buffers and
+// hands it to an encoder thread through a lock-free queue; the encoder writes
+// it out and returns the buffer through a second queue. When every buffer is
+// still waiting to be encoded the frame is dropped and counted, instead of
+// waiting for the encoder.
+//
+// Output is either a QOI image per frame (<prefix>_000000.qoi, ...; numbered
+// by frame so drops show up as gaps) or, for a path ending in .raw, all frames
+// appended as raw RGBA at the size capture started with.
+class FrameCapture {
+public:
+    static const int MAX_BUFFERS = 32;
+
+    struct Frame {
+        std::unique_ptr<unsigned char[]> pixels; // width * height RGBA, `pitch` bytes per row
+        int w = 0, h = 0;                        // Part of the buffer holding this frame
+        long number = 0;
+    };
+
+    int width = 0, height = 0, pitch = 0; // Buffer size, fixed while capturing
+
+    // Render thread only
+    long captured = 0;
+    long dropped = 0;
+    double readMs = 0;
+
+    // Written by the encoder thread
+    std::atomic<long> written{ 0 };
+    std::atomic<long> failed{ 0 };
+    std::atomic<long long> encodeMicros{ 0 };
+
+    ~FrameCapture() { stop(); }
+
+    bool active() const { return encoder.joinable(); }
+
+    bool start(const std::string& path, int w, int h, int bufferCount) {
+        stop();
+        width = w;
+        height = h;
+        pitch = w * 4;
+        raw = path.size() > 4 && path.compare(path.size() - 4, 4, ".raw") == 0;
+        prefix = path;
+        if (!raw && prefix.size() > 4 && prefix.compare(prefix.size() - 4, 4, ".qoi") == 0) prefix.resize(prefix.size() - 4);
+        if (raw) {
+            rawFile = std::fopen(path.c_str(), "wb");
+            if (!rawFile) return false;
+        }
+        else {
+            encoded.reset(new unsigned char[qoiMaxSize(w, h)]);
+        }
+
+        int count = bufferCount < 2 ? 2 : bufferCount > MAX_BUFFERS ? MAX_BUFFERS : bufferCount;
+        frames.clear();
+        frames.resize(count);
+        for (int i = 0; i < count; i++) {
+            frames[i].pixels.reset(new unsigned char[(size_t)pitch * h]);
+            freeFrames.tryPush(i);
+        }
+
+        quit = false;
+        encoder = std::thread([this] { encoderLoop(); });
+        return true;
+    }
+
+    // Writes out every frame already handed over, then ends the capture.
+    void stop() {
+        if (!encoder.joinable()) return;
+        quit = true;
+        encoder.join();
+        if (rawFile) std::fclose(rawFile);
+        rawFile = nullptr;
+        int i;
+        while (freeFrames.tryPop(i)) {}
+        held = -1;
+    }
+
+    // Buffer to read the next frame into, or null if the encoder still has all
+    // of them (the frame is counted as dropped).
+    Frame* acquire() {
+        if (held < 0 && !freeFrames.tryPop(held)) {
+            dropped++;
+            return nullptr;
+        }
+        return &frames[held];
+    }
+
+    // Hands the acquired buffer, now holding a w x h frame, to the encoder.
+    // A buffer that is acquired but not submitted is simply reused next time.
+    void submit(int w, int h, long number) {
+        Frame& frame = frames[held];
+        frame.w = w;
+        frame.h = h;
+        frame.number = number;
+        filledFrames.tryPush(held); // Never full: no more buffers than slots
+        held = -1;
+        captured++;
+    }
+
+    int pending() const { return (int)filledFrames.size(); }
+
+private:
+    std::vector<Frame> frames;
+    SpscQueue<int, MAX_BUFFERS> freeFrames;   // Encoder -> render thread
+    SpscQueue<int, MAX_BUFFERS> filledFrames; // Render thread -> encoder
+    int held = -1;
+    std::thread encoder;
+    std::atomic<bool> quit{ false };
+
+    bool raw = false;
+    std::string prefix;
+    FILE* rawFile = nullptr;
+    std::unique_ptr<unsigned char[]> encoded;
+    std::vector<unsigned char> padding;
+
+    void encoderLoop() {
+        if (raw) padding.assign(pitch, 0);
+        for (;;) {
+            int i;
+            if (!filledFrames.tryPop(i)) {
+                // Only stop once everything submitted before stop() is written
+                if (quit.load()) {
+                    if (!filledFrames.tryPop(i)) return;
+                }
+                else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            bool ok = raw ? writeRaw(frames[i]) : writeQoi(frames[i]);
+            encodeMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            if (ok) written++;
+            else failed++;
+
+            freeFrames.tryPush(i);
+        }
+    }
+
+    bool writeQoi(const Frame& frame) {
+        char name[1024];
+        std::snprintf(name, sizeof(name), "%s_%06ld.qoi", prefix.c_str(), frame.number);
+        size_t size = qoiEncode(frame.pixels.get(), frame.w, frame.h, pitch, encoded.get());
+        FILE* f = std::fopen(name, "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(encoded.get(), 1, size, f) == size;
+        return std::fclose(f) == 0 && ok;
+    }
+
+    // Raw video needs every frame the same size: a frame smaller than the
+    // capture (the window shrank) is padded with black.
+    bool writeRaw(const Frame& frame) {
+        bool ok = true;
+        for (int y = 0; y < height; y++) {
+            size_t used = y < frame.h ? (size_t)frame.w * 4 : 0;
+            if (used && std::fwrite(frame.pixels.get() + (size_t)y * pitch, 1, used, rawFile) != used) ok = false;
+            if (used < (size_t)pitch && std::fwrite(padding.data(), 1, pitch - used, rawFile) != pitch - used) ok = false;
+        }
+        return ok;
+    }
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+// SMASH_SSE2 is defined, and the SSE2 intrinsics included, when the target
+// has SSE2: always on x64, with /arch:SSE2 on 32-bit MSVC and with -msse2
+// elsewhere. Code using it keeps a scalar path for other targets.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SMASH_SSE2 1
+#include <emmintrin.h>
+#endif
@@ -0,0 +1,567 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "WorkerPool.h"
+#include "Simd.h"
+
+// Blend modes, numbered like blendSortIndex(); anything else blends like RASTER_BLEND.
+enum RasterBlend { RASTER_NONE, RASTER_BLEND, RASTER_ADD };
+
+// Draws screen-space triangles into an ARGB8888 framebuffer on the CPU, for
+// machines where SDL falls back to its own software renderer.
+//
+// Triangles are snapped to 1/16 pixel and set up once. finish() then bins them
+// into 64x64 tiles, each binning job taking a slice of the triangles, and
+// rasterizes every tile as a job of its own: a tile clears itself and draws
+// its triangles in submission order, so tiles never share pixels and need no
+// locking. Coverage uses integer edge functions with a tie-breaking rule, so
+// triangles sharing an edge (circle fans, quads) cover each pixel exactly
+// once and blended shapes show no seams. Inside a tile the edges are stepped
+// four pixels at a time with SSE2.
+class SoftRasterizer {
+public:
+    static const int TILE = 64;
+    static const int SUBPIXEL = 16;
+    static const int MAX_COORD = 8192; // Triangles reaching further are dropped; keeps tile math in 32 bits
+    static const int MAX_BINNERS = 8;
+
+    int width = 0, height = 0;
+    int stride = 0; // Pixels per row, a multiple of 4
+    std::vector<Uint32> pixels;
+
+    // Per-frame counters
+    int triangleCount = 0;
+    long binnedCount = 0;
+
+    void setPool(WorkerPool* p) { pool = p; }
+
+    int pitch() const { return stride * 4; }
+
+    // Copies a texture's source image; ids count from 1 in the order added,
+    // like Renderer::addTexture. Without an image the texture samples white.
+    Uint16 addTexture(SDL_Surface* surface) {
+        Texture t;
+        SDL_Surface* argb = surface ? SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0) : nullptr;
+        if (argb) {
+            Uint32 key = 0;
+            bool keyed = SDL_GetColorKey(surface, &key) == 0;
+            Uint8 kr = 0, kg = 0, kb = 0;
+            if (keyed) SDL_GetRGB(key, surface->format, &kr, &kg, &kb);
+            Uint32 keyRGB = (Uint32)kr << 16 | (Uint32)kg << 8 | kb;
+
+            t.w = argb->w;
+            t.h = argb->h;
+            t.texels.resize((size_t)t.w * t.h);
+            SDL_LockSurface(argb);
+            for (int y = 0; y < t.h; y++) {
+                const Uint32* row = (const Uint32*)((const Uint8*)argb->pixels + y * argb->pitch);
+                for (int x = 0; x < t.w; x++) {
+                    Uint32 texel = row[x];
+                    t.texels[y * t.w + x] = keyed && (texel & 0xFFFFFF) == keyRGB ? 0 : texel;
+                }
+            }
+            SDL_UnlockSurface(argb);
+            SDL_FreeSurface(argb);
+        }
+        textures.push_back(std::move(t));
+        return (Uint16)textures.size();
+    }
+
+    // Starts a frame. The framebuffer is only cleared to `clear` while tiles
+    // are drawn, in parallel.
+    void begin(int w, int h, Uint32 clear) {
+        if (w != width || h != height) {
+            width = w;
+            height = h;
+            stride = (w + 3) & ~3;
+            pixels.assign((size_t)stride * h, 0);
+        }
+        clearColor = clear | 0xFF000000;
+        tris.clear();
+    }
+
+    // Adds indexCount / 3 triangles. xy holds screen-space (x, y) pairs; uv is
+    // only read for textured triangles (texture != 0).
+    void addTriangles(const float* xy, const SDL_Color* colors, const float* uv, const int* indices, int indexCount, int blend, Uint16 texture) {
+        if (blend > RASTER_ADD) blend = RASTER_BLEND;
+        if (texture > textures.size() || (texture && textures[texture - 1].texels.empty())) texture = 0;
+        for (int i = 0; i + 2 < indexCount; i += 3) {
+            int v[3] = { indices[i], indices[i + 1], indices[i + 2] };
+            Triangle t;
+            bool inRange = true;
+            for (int k = 0; k < 3; k++) {
+                float x = xy[v[k] * 2], y = xy[v[k] * 2 + 1];
+                // Also false for NaN
+                inRange = inRange && std::abs(x) < MAX_COORD && std::abs(y) < MAX_COORD;
+                t.x[k] = (int)std::floor(x * SUBPIXEL + 0.5f);
+                t.y[k] = (int)std::floor(y * SUBPIXEL + 0.5f);
+            }
+            if (!inRange) continue;
+
+            // Make every edge function positive inside
+            long long area = (long long)(t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (long long)(t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+            if (area == 0) continue;
+            if (area > 0) {
+                std::swap(t.x[1], t.x[2]);
+                std::swap(t.y[1], t.y[2]);
+                std::swap(v[1], v[2]);
+            }
+
+            // Pixels whose centers fall inside the bounds, clipped to the framebuffer
+            int minX = std::min(t.x[0], std::min(t.x[1], t.x[2]));
+            int maxX = std::max(t.x[0], std::max(t.x[1], t.x[2]));
+            int minY = std::min(t.y[0], std::min(t.y[1], t.y[2]));
+            int maxY = std::max(t.y[0], std::max(t.y[1], t.y[2]));
+            t.minX = std::max(0, floorDiv(minX - SUBPIXEL / 2 + SUBPIXEL - 1, SUBPIXEL));
+            t.maxX = std::min(width - 1, floorDiv(maxX - SUBPIXEL / 2, SUBPIXEL));
+            t.minY = std::max(0, floorDiv(minY - SUBPIXEL / 2 + SUBPIXEL - 1, SUBPIXEL));
+            t.maxY = std::min(height - 1, floorDiv(maxY - SUBPIXEL / 2, SUBPIXEL));
+            if (t.minX > t.maxX || t.minY > t.maxY) continue;
+
+            for (int k = 0; k < 3; k++) {
+                int j = (k + 1) % 3;
+                int a = t.y[j] - t.y[k], b = t.x[k] - t.x[j];
+                // Ties on an edge go to one of the two triangles sharing it
+                t.bias[k] = (a > 0 || (a == 0 && b < 0)) ? 0 : -1;
+                t.c[k] = colors[v[k]];
+                t.u[k] = texture ? uv[v[k] * 2] : 0;
+                t.v[k] = texture ? uv[v[k] * 2 + 1] : 0;
+            }
+            t.texture = texture;
+            t.uniform = sameColor(t.c[0], t.c[1]) && sameColor(t.c[0], t.c[2]);
+            t.blend = (Uint8)blend;
+            SDL_Color c = t.c[0];
+            t.color = (Uint32)c.a << 24 | (Uint32)c.r << 16 | (Uint32)c.g << 8 | c.b;
+            if (t.uniform && !texture) {
+                if (blend != RASTER_NONE && c.a == 0) continue;
+                if (blend == RASTER_BLEND && c.a == 255) t.blend = RASTER_NONE;
+            }
+            if (texture) {
+                // Texel coordinates as a linear function of the pixel position
+                const Texture& tex = textures[texture - 1];
+                double x0 = (double)t.x[0] / SUBPIXEL, y0 = (double)t.y[0] / SUBPIXEL;
+                double e1x = (double)t.x[1] / SUBPIXEL - x0, e1y = (double)t.y[1] / SUBPIXEL - y0;
+                double e2x = (double)t.x[2] / SUBPIXEL - x0, e2y = (double)t.y[2] / SUBPIXEL - y0;
+                double det = e1x * e2y - e2x * e1y;
+                double u0 = t.u[0] * tex.w, u1 = t.u[1] * tex.w - u0, u2 = t.u[2] * tex.w - u0;
+                double v0 = t.v[0] * tex.h, v1 = t.v[1] * tex.h - v0, v2 = t.v[2] * tex.h - v0;
+                t.dudx = (u1 * e2y - u2 * e1y) / det;
+                t.dudy = (u2 * e1x - u1 * e2x) / det;
+                t.dvdx = (v1 * e2y - v2 * e1y) / det;
+                t.dvdy = (v2 * e1x - v1 * e2x) / det;
+                t.u0 = u0 - t.dudx * x0 - t.dudy * y0;
+                t.v0 = v0 - t.dvdx * x0 - t.dvdy * y0;
+            }
+            tris.push_back(t);
+        }
+    }
+
+    // Bins and draws everything added since begin().
+    void finish() {
+        triangleCount = (int)tris.size();
+        tilesX = (width + TILE - 1) / TILE;
+        tilesY = (height + TILE - 1) / TILE;
+        int tileCount = tilesX * tilesY;
+
+        int workers = pool ? pool->workerCount() : 0;
+        // Small frames are not worth splitting
+        binners = std::max(1, std::min(std::min(workers + 1, (int)MAX_BINNERS), triangleCount / 256));
+        if ((int)bins.size() < binners * tileCount) {
+            // Room for a busy tile up front, so bins rarely grow mid-game
+            size_t first = bins.size();
+            bins.resize(binners * tileCount);
+            for (size_t i = first; i < bins.size(); i++) bins[i].reserve(256);
+        }
+        for (int i = 0; i < binners * tileCount; i++) bins[i].clear();
+
+        jobs.clear();
+        binJobs.resize(binners);
+        for (int i = 0; i < binners; i++) {
+            binJobs[i] = { this, i };
+            jobs.push_back({ &SoftRasterizer::binJob, &binJobs[i] });
+        }
+        runJobs();
+
+        binnedCount = 0;
+        for (int i = 0; i < binners * tileCount; i++) binnedCount += (long)bins[i].size();
+
+        jobs.clear();
+        tileJobs.resize(tileCount);
+        for (int i = 0; i < tileCount; i++) {
+            tileJobs[i] = { this, i };
+            jobs.push_back({ &SoftRasterizer::tileJob, &tileJobs[i] });
+        }
+        runJobs();
+    }
+
+private:
+    struct Texture {
+        std::vector<Uint32> texels;
+        int w = 0, h = 0;
+    };
+
+    struct Triangle {
+        int x[3], y[3]; // Fixed point, SUBPIXEL per pixel
+        int bias[3];
+        int minX, minY, maxX, maxY;
+        SDL_Color c[3];
+        float u[3], v[3];
+        Uint32 color; // ARGB of the first vertex
+        double u0, v0, dudx, dudy, dvdx, dvdy; // Texel coordinates at pixel (0, 0) and their slopes
+        Uint16 texture;
+        Uint8 blend;
+        bool uniform; // All three vertices have the same color
+    };
+
+    struct JobContext {
+        SoftRasterizer* self;
+        int index;
+    };
+
+    // One linear function per edge over the pixels of a tile: value = start +
+    // x * stepX + y * stepY, with x and y counted from the rectangle's corner
+    struct Edge {
+        int start, stepX, stepY;
+    };
+
+    std::vector<Triangle> tris;
+    std::vector<Texture> textures;
+    Uint32 clearColor = 0xFF000000;
+    WorkerPool* pool = nullptr;
+    int tilesX = 0, tilesY = 0;
+    int binners = 1;
+    std::vector<std::vector<int>> bins; // [binner * tileCount + tile], triangle indices in order
+    std::vector<JobContext> binJobs, tileJobs;
+    std::vector<Job> jobs;
+
+    static int floorDiv(int a, int b) {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    static bool sameColor(SDL_Color a, SDL_Color b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+
+    void runJobs() {
+        if (pool) pool->run(jobs.data(), (int)jobs.size());
+        else for (const Job& job : jobs) job.fn(job.ctx);
+    }
+
+    static void binJob(void* ctx) {
+        JobContext& job = *static_cast<JobContext*>(ctx);
+        job.self->bin(job.index);
+    }
+
+    static void tileJob(void* ctx) {
+        JobContext& job = *static_cast<JobContext*>(ctx);
+        job.self->drawTile(job.index);
+    }
+
+    // Binner b takes its slice of the triangles, so every tile sees each
+    // binner's triangles in order and the binners one after another.
+    void bin(int b) {
+        int count = (int)tris.size();
+        int first = (int)((long long)count * b / binners);
+        int last = (int)((long long)count * (b + 1) / binners);
+        std::vector<int>* own = &bins[b * tilesX * tilesY];
+        for (int i = first; i < last; i++) {
+            const Triangle& t = tris[i];
+            for (int ty = t.minY / TILE; ty <= t.maxY / TILE; ty++) {
+                for (int tx = t.minX / TILE; tx <= t.maxX / TILE; tx++) {
+                    own[ty * tilesX + tx].push_back(i);
+                }
+            }
+        }
+    }
+
+    void drawTile(int tile) {
+        int x0 = (tile % tilesX) * TILE, y0 = (tile / tilesX) * TILE;
+        int x1 = std::min(x0 + TILE, width) - 1, y1 = std::min(y0 + TILE, height) - 1;
+        for (int y = y0; y <= y1; y++) {
+            std::fill(&pixels[(size_t)y * stride + x0], &pixels[(size_t)y * stride + x1] + 1, clearColor);
+        }
+
+        int tileCount = tilesX * tilesY;
+        for (int b = 0; b < binners; b++) {
+            for (int i : bins[b * tileCount + tile]) drawTriangle(tris[i], x0, y0, x1, y1);
+        }
+    }
+
+    void drawTriangle(const Triangle& t, int x0, int y0, int x1, int y1) {
+        int rx0 = std::max(t.minX, x0), ry0 = std::max(t.minY, y0);
+        int rx1 = std::min(t.maxX, x1), ry1 = std::min(t.maxY, y1);
+        if (rx0 > rx1 || ry0 > ry1) return;
+        // Groups of four pixels start on multiples of 4, like tiles and rows
+        int ax0 = rx0 & ~3;
+
+        // Edges the whole rectangle is inside of need no testing; a rectangle
+        // outside any edge has nothing to draw. Edges that remain cross the
+        // rectangle, so their values there fit in 32 bits.
+        Edge edges[3];
+        int edgeCount = 0;
+        for (int k = 0; k < 3; k++) {
+            int j = (k + 1) % 3;
+            long long a = t.y[j] - t.y[k], b = t.x[k] - t.x[j];
+            long long start = a * ((long long)ax0 * SUBPIXEL + SUBPIXEL / 2 - t.x[k])
+                + b * ((long long)ry0 * SUBPIXEL + SUBPIXEL / 2 - t.y[k]) + t.bias[k];
+            long long spanX = a * SUBPIXEL * (rx1 - ax0), spanY = b * SUBPIXEL * (ry1 - ry0);
+            long long lowest = start + std::min(0LL, spanX) + std::min(0LL, spanY);
+            long long highest = start + std::max(0LL, spanX) + std::max(0LL, spanY);
+            if (highest < 0) return;
+            if (lowest >= 0) continue;
+            edges[edgeCount++] = { (int)start, (int)(a * SUBPIXEL), (int)(b * SUBPIXEL) };
+        }
+
+        if (!t.uniform) drawShaded(t, edges, edgeCount, ax0, rx0, ry0, rx1, ry1);
+        else if (t.texture) drawTextured(t, edges, edgeCount, ax0, rx0, ry0, rx1, ry1);
+        else drawFlat(t, edges, edgeCount, ax0, rx0, ry0, rx1, ry1);
+    }
+
+#ifdef SMASH_SSE2
+    typedef __m128i Coverage; // All ones in the lanes of covered pixels
+#else
+    typedef int Coverage;     // One bit per covered pixel
+#endif
+
+    // Walks the rectangle in groups of four pixels, calling
+    // shade(row, x, y, covered) for every group with a pixel to draw.
+    template<typename Shade>
+    void scan(const Edge* edges, int edgeCount, int ax0, int rx0, int ry0, int rx1, int ry1, Shade shade) {
+#ifdef SMASH_SSE2
+        const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i negative = _mm_set1_epi32(-1);
+        __m128i stepX4[3], stepY[3], rowValue[3];
+        for (int k = 0; k < edgeCount; k++) {
+            int e = edges[k].start, s = edges[k].stepX;
+            rowValue[k] = _mm_setr_epi32(e, e + s, e + s * 2, e + s * 3);
+            stepX4[k] = _mm_set1_epi32(s * 4);
+            stepY[k] = _mm_set1_epi32(edges[k].stepY);
+        }
+        const __m128i first = _mm_set1_epi32(rx0 - 1), last = _mm_set1_epi32(rx1 + 1);
+
+        for (int y = ry0; y <= ry1; y++) {
+            Uint32* row = &pixels[(size_t)y * stride];
+            __m128i value[3];
+            for (int k = 0; k < edgeCount; k++) value[k] = rowValue[k];
+            for (int x = ax0; x <= rx1; x += 4) {
+                // Only pixels within rx0 .. rx1...
+                __m128i px = _mm_add_epi32(_mm_set1_epi32(x), lanes);
+                __m128i covered = _mm_and_si128(_mm_cmpgt_epi32(px, first), _mm_cmplt_epi32(px, last));
+                // ...and inside every edge
+                for (int k = 0; k < edgeCount; k++) {
+                    covered = _mm_and_si128(covered, _mm_cmpgt_epi32(value[k], negative));
+                    value[k] = _mm_add_epi32(value[k], stepX4[k]);
+                }
+                if (_mm_movemask_epi8(covered) != 0) shade(row, x, y, covered);
+            }
+            for (int k = 0; k < edgeCount; k++) rowValue[k] = _mm_add_epi32(rowValue[k], stepY[k]);
+        }
+#else
+        for (int y = ry0; y <= ry1; y++) {
+            Uint32* row = &pixels[(size_t)y * stride];
+            for (int x = ax0; x <= rx1; x += 4) {
+                int covered = 0;
+                for (int lane = 0; lane < 4; lane++) {
+                    int px = x + lane;
+                    if (px >= rx0 && px <= rx1 && covers(edges, edgeCount, px - ax0, y - ry0)) covered |= 1 << lane;
+                }
+                if (covered) shade(row, x, y, covered);
+            }
+        }
+#endif
+    }
+
+#ifdef SMASH_SSE2
+    // (src * a + dst * (255 - a)) / 255 per channel, rounded, with a per pixel
+    // in the top byte of src.
+    static __m128i blendOver(__m128i src, __m128i dst) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i max = _mm_set1_epi16(255), half = _mm_set1_epi16(128);
+        __m128i srcLo = _mm_unpacklo_epi8(src, zero), srcHi = _mm_unpackhi_epi8(src, zero);
+        __m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(srcLo, aLo), _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), _mm_sub_epi16(max, aLo))), half);
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(srcHi, aHi), _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), _mm_sub_epi16(max, aHi))), half);
+        return divide255(lo, hi);
+    }
+
+    // dst + src * a / 255 per channel, saturating.
+    static __m128i blendAdd(__m128i src, __m128i dst) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i half = _mm_set1_epi16(128);
+        __m128i srcLo = _mm_unpacklo_epi8(src, zero), srcHi = _mm_unpackhi_epi8(src, zero);
+        __m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(srcLo, aLo), half);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(srcHi, aHi), half);
+        return _mm_adds_epu8(dst, divide255(lo, hi));
+    }
+
+    // x / 255 for x + 128 in each 16-bit lane, rounded, packed back to bytes
+    // with alpha set.
+    static __m128i divide255(__m128i lo, __m128i hi) {
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32((int)0xFF000000));
+    }
+#endif
+
+    // Single color: the common case.
+    void drawFlat(const Triangle& t, const Edge* edges, int edgeCount, int ax0, int rx0, int ry0, int rx1, int ry1) {
+        Uint32 c = t.color;
+        int mode = t.blend;
+#ifdef SMASH_SSE2
+        const __m128i src = _mm_set1_epi32((int)c);
+        const __m128i opaque = _mm_set1_epi32((int)(c | 0xFF000000));
+        scan(edges, edgeCount, ax0, rx0, ry0, rx1, ry1, [&](Uint32* row, int x, int, __m128i covered) {
+            __m128i dst = _mm_loadu_si128((const __m128i*)(row + x));
+            __m128i out = mode == RASTER_NONE ? opaque : mode == RASTER_ADD ? blendAdd(src, dst) : blendOver(src, dst);
+            out = _mm_or_si128(_mm_and_si128(covered, out), _mm_andnot_si128(covered, dst));
+            _mm_storeu_si128((__m128i*)(row + x), out);
+        });
+#else
+        scan(edges, edgeCount, ax0, rx0, ry0, rx1, ry1, [&](Uint32* row, int x, int, int covered) {
+            for (int lane = 0; lane < 4; lane++) {
+                if (covered >> lane & 1) row[x + lane] = blendPixel(row[x + lane], c >> 16 & 255, c >> 8 & 255, c & 255, c >> 24, mode);
+            }
+        });
+#endif
+    }
+
+    // Sprites: a texture times one color, nearest sampled. Texel coordinates
+    // step in 16.16 fixed point; texels are fetched one by one and blended
+    // four at a time.
+    void drawTextured(const Triangle& t, const Edge* edges, int edgeCount, int ax0, int rx0, int ry0, int rx1, int ry1) {
+        const Texture& tex = textures[t.texture - 1];
+        const Uint32 c = t.color;
+        const bool white = c == 0xFFFFFFFF;
+        const int mode = t.blend;
+        const double limit = 1 << 14; // Keeps 64 pixels of steps in range
+        const int dudx = (int)(std::max(-limit, std::min(limit, t.dudx)) * 65536);
+        const int dvdx = (int)(std::max(-limit, std::min(limit, t.dvdx)) * 65536);
+        int rowY = -1, rowU = 0, rowV = 0;
+
+        scan(edges, edgeCount, ax0, rx0, ry0, rx1, ry1, [&](Uint32* row, int x, int y, Coverage covered) {
+            if (y != rowY) {
+                double cx = ax0 + 0.5, cy = y + 0.5;
+                rowU = (int)std::floor(std::max(-limit, std::min(limit, t.u0 + t.dudx * cx + t.dudy * cy)) * 65536);
+                rowV = (int)std::floor(std::max(-limit, std::min(limit, t.v0 + t.dvdx * cx + t.dvdy * cy)) * 65536);
+                rowY = y;
+            }
+            // All four lanes are fetched, covered or not: clamping keeps them in
+            // the texture and it saves a branch per pixel
+            int u = rowU + (x - ax0) * dudx, v = rowV + (x - ax0) * dvdx;
+            Uint32 texel[4];
+            if (dvdx == 0) {
+                // Upright sprites stay on one texel row
+                const Uint32* texRow = &tex.texels[clampTexel(v, tex.h) * tex.w];
+                for (int lane = 0; lane < 4; lane++, u += dudx) texel[lane] = texRow[clampTexel(u, tex.w)];
+            }
+            else {
+                for (int lane = 0; lane < 4; lane++, u += dudx, v += dvdx) texel[lane] = tex.texels[clampTexel(v, tex.h) * tex.w + clampTexel(u, tex.w)];
+            }
+            if (!white) {
+                for (int lane = 0; lane < 4; lane++) texel[lane] = modulate(texel[lane], c);
+            }
+            // Nothing to blend where the texture is transparent
+            if (mode != RASTER_NONE && ((texel[0] | texel[1] | texel[2] | texel[3]) >> 24) == 0) return;
+#ifdef SMASH_SSE2
+            __m128i src = _mm_setr_epi32((int)texel[0], (int)texel[1], (int)texel[2], (int)texel[3]);
+            __m128i dst = _mm_loadu_si128((const __m128i*)(row + x));
+            __m128i out = mode == RASTER_NONE ? _mm_or_si128(src, _mm_set1_epi32((int)0xFF000000))
+                : mode == RASTER_ADD ? blendAdd(src, dst) : blendOver(src, dst);
+            out = _mm_or_si128(_mm_and_si128(covered, out), _mm_andnot_si128(covered, dst));
+            _mm_storeu_si128((__m128i*)(row + x), out);
+#else
+            for (int lane = 0; lane < 4; lane++) {
+                Uint32 s = texel[lane];
+                if (covered >> lane & 1) row[x + lane] = blendPixel(row[x + lane], s >> 16 & 255, s >> 8 & 255, s & 255, s >> 24, mode);
+            }
+#endif
+        });
+    }
+
+    // Texel index of a 16.16 coordinate, clamped to the texture.
+    static int clampTexel(int fixed, int size) {
+        int i = fixed >> 16;
+        return i < 0 ? 0 : i >= size ? size - 1 : i;
+    }
+
+    // Texel times color per channel, rounded.
+    static Uint32 modulate(Uint32 texel, Uint32 c) {
+        Uint32 out = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            Uint32 product = (texel >> shift & 255) * (c >> shift & 255);
+            out |= (product + 127) / 255 << shift;
+        }
+        return out;
+    }
+
+    static bool covers(const Edge* edges, int edgeCount, int dx, int dy) {
+        for (int k = 0; k < edgeCount; k++) {
+            if (edges[k].start + dx * edges[k].stepX + dy * edges[k].stepY < 0) return false;
+        }
+        return true;
+    }
+
+    static Uint32 blendPixel(Uint32 dst, int r, int g, int b, int a, int mode) {
+        int dr = dst >> 16 & 255, dg = dst >> 8 & 255, db = dst & 255;
+        if (mode == RASTER_NONE) {
+            dr = r; dg = g; db = b;
+        }
+        else if (mode == RASTER_ADD) {
+            dr = std::min(255, dr + (r * a + 127) / 255);
+            dg = std::min(255, dg + (g * a + 127) / 255);
+            db = std::min(255, db + (b * a + 127) / 255);
+        }
+        else {
+            dr = (r * a + dr * (255 - a) + 127) / 255;
+            dg = (g * a + dg * (255 - a) + 127) / 255;
+            db = (b * a + db * (255 - a) + 127) / 255;
+        }
+        return 0xFF000000 | (Uint32)dr << 16 | (Uint32)dg << 8 | (Uint32)db;
+    }
+
+    // Colors that differ between vertices, optionally textured: interpolated
+    // one pixel at a time. Nothing in the game draws these yet.
+    void drawShaded(const Triangle& t, const Edge* edges, int edgeCount, int ax0, int rx0, int ry0, int rx1, int ry1) {
+        float x0 = (float)t.x[0] / SUBPIXEL, y0 = (float)t.y[0] / SUBPIXEL;
+        float e1x = (float)(t.x[1] - t.x[0]) / SUBPIXEL, e1y = (float)(t.y[1] - t.y[0]) / SUBPIXEL;
+        float e2x = (float)(t.x[2] - t.x[0]) / SUBPIXEL, e2y = (float)(t.y[2] - t.y[0]) / SUBPIXEL;
+        float invDet = 1.0f / (e1x * e2y - e2x * e1y);
+        const Texture* texture = t.texture ? &textures[t.texture - 1] : nullptr;
+
+        for (int y = ry0; y <= ry1; y++) {
+            Uint32* row = &pixels[(size_t)y * stride];
+            float py = y + 0.5f - y0;
+            for (int x = rx0; x <= rx1; x++) {
+                if (!covers(edges, edgeCount, x - ax0, y - ry0)) continue;
+                float px = x + 0.5f - x0;
+                float l1 = (px * e2y - e2x * py) * invDet;
+                float l2 = (e1x * py - px * e1y) * invDet;
+                float l0 = 1 - l1 - l2;
+
+                float r = l0 * t.c[0].r + l1 * t.c[1].r + l2 * t.c[2].r;
+                float g = l0 * t.c[0].g + l1 * t.c[1].g + l2 * t.c[2].g;
+                float b = l0 * t.c[0].b + l1 * t.c[1].b + l2 * t.c[2].b;
+                float a = l0 * t.c[0].a + l1 * t.c[1].a + l2 * t.c[2].a;
+                if (texture) {
+                    float u = l0 * t.u[0] + l1 * t.u[1] + l2 * t.u[2];
+                    float v = l0 * t.v[0] + l1 * t.v[1] + l2 * t.v[2];
+                    int tx = std::min(texture->w - 1, std::max(0, (int)(u * texture->w)));
+                    int ty = std::min(texture->h - 1, std::max(0, (int)(v * texture->h)));
+                    Uint32 texel = texture->texels[ty * texture->w + tx];
+                    r *= (texel >> 16 & 255) / 255.0f;
+                    g *= (texel >> 8 & 255) / 255.0f;
+                    b *= (texel & 255) / 255.0f;
+                    a *= (texel >> 24) / 255.0f;
+                }
+                int ia = (int)(a + 0.5f);
+                if (t.blend != RASTER_NONE && ia <= 0) continue;
+                row[x] = blendPixel(row[x], (int)(r + 0.5f), (int)(g + 0.5f), (int)(b + 0.5f), std::min(255, ia), t.blend);
+            }
+        }
+    }
+};
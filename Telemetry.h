@@ -0,0 +1,209 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include "SpscQueue.h"
+
+// One tick of gameplay and performance data. Every field is 4 bytes so that
+// each one becomes a column of the file as is.
+struct TelemetryRecord {
+    unsigned tick;    // Ticks since telemetry started
+    unsigned frame;   // Frame of the current game
+    int score;
+    int scoreDelta;
+    int level;
+    float health;
+    int kills;
+    int smashes;      // Smashes that ended this tick...
+    int smashKills;   // ...and how many enemies they killed between them
+    int blocks;
+    int headHits;
+    int enemies;
+    int particles;
+    float tickMs;     // Simulation
+    float frameMs;    // Whole frame, simulation included
+};
+
+struct TelemetryColumn {
+    const char* name;
+    char type; // 'u' unsigned, 'i' int, 'f' float; all 4 bytes
+    size_t offset;
+};
+
+static const TelemetryColumn TELEMETRY_COLUMNS[] = {
+    { "tick", 'u', offsetof(TelemetryRecord, tick) },
+    { "frame", 'u', offsetof(TelemetryRecord, frame) },
+    { "score", 'i', offsetof(TelemetryRecord, score) },
+    { "score_delta", 'i', offsetof(TelemetryRecord, scoreDelta) },
+    { "level", 'i', offsetof(TelemetryRecord, level) },
+    { "health", 'f', offsetof(TelemetryRecord, health) },
+    { "kills", 'i', offsetof(TelemetryRecord, kills) },
+    { "smashes", 'i', offsetof(TelemetryRecord, smashes) },
+    { "smash_kills", 'i', offsetof(TelemetryRecord, smashKills) },
+    { "blocks", 'i', offsetof(TelemetryRecord, blocks) },
+    { "head_hits", 'i', offsetof(TelemetryRecord, headHits) },
+    { "enemies", 'i', offsetof(TelemetryRecord, enemies) },
+    { "particles", 'i', offsetof(TelemetryRecord, particles) },
+    { "tick_ms", 'f', offsetof(TelemetryRecord, tickMs) },
+    { "frame_ms", 'f', offsetof(TelemetryRecord, frameMs) },
+};
+static const int TELEMETRY_COLUMN_COUNT = sizeof(TELEMETRY_COLUMNS) / sizeof(TELEMETRY_COLUMNS[0]);
+static_assert(sizeof(TelemetryRecord) == TELEMETRY_COLUMN_COUNT * 4, "every field needs a column");
+
+// File layout, native byte order:
+//   "SMTL", u32 version, u32 column count, then per column u8 type, u8 name
+//   length and the name;
+//   blocks of u32 row count followed by each column's values for those rows.
+static const unsigned TELEMETRY_VERSION = 1;
+
+// Streams records to a columnar file. The game thread hands each record to a
+// background writer through a lock-free queue and never waits on the disk; if
+// the writer falls that far behind, records are dropped and counted. The
+// writer gathers BLOCK_ROWS records and writes them column by column.
+class TelemetryWriter {
+public:
+    static const int QUEUE_SIZE = 8192;
+    static const int BLOCK_ROWS = 4096;
+
+    long dropped = 0; // Game thread only
+    std::atomic<long> written{ 0 };
+
+    ~TelemetryWriter() { stop(); }
+
+    bool active() const { return writer.joinable(); }
+
+    bool start(const char* path) {
+        stop();
+        file = std::fopen(path, "wb");
+        if (!file) return false;
+
+        std::fwrite("SMTL", 1, 4, file);
+        unsigned header[2] = { TELEMETRY_VERSION, (unsigned)TELEMETRY_COLUMN_COUNT };
+        std::fwrite(header, sizeof(header), 1, file);
+        for (const TelemetryColumn& c : TELEMETRY_COLUMNS) {
+            unsigned char meta[2] = { (unsigned char)c.type, (unsigned char)std::strlen(c.name) };
+            std::fwrite(meta, 1, 2, file);
+            std::fwrite(c.name, 1, meta[1], file);
+        }
+
+        rows.reset(new TelemetryRecord[BLOCK_ROWS]);
+        columns.reset(new unsigned char[(size_t)BLOCK_ROWS * sizeof(TelemetryRecord)]);
+        rowCount = 0;
+        quit = false;
+        writer = std::thread([this] { writerLoop(); });
+        return true;
+    }
+
+    // Writes out everything recorded so far and closes the file.
+    void stop() {
+        if (!writer.joinable()) return;
+        quit = true;
+        writer.join();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    // Game thread only.
+    void record(const TelemetryRecord& r) {
+        if (!writer.joinable()) return;
+        if (!queue.tryPush(r)) dropped++;
+    }
+
+private:
+    SpscQueue<TelemetryRecord, QUEUE_SIZE> queue;
+    std::thread writer;
+    std::atomic<bool> quit{ false };
+    FILE* file = nullptr;
+    std::unique_ptr<TelemetryRecord[]> rows;
+    std::unique_ptr<unsigned char[]> columns;
+    int rowCount = 0;
+
+    void writerLoop() {
+        for (;;) {
+            if (queue.tryPop(rows[rowCount])) {
+                if (++rowCount == BLOCK_ROWS) writeBlock();
+                continue;
+            }
+            // Only stop once everything recorded before stop() is in
+            if (quit.load()) {
+                if (queue.size() > 0) continue;
+                writeBlock();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    void writeBlock() {
+        if (rowCount == 0) return;
+        unsigned char* out = columns.get();
+        for (const TelemetryColumn& c : TELEMETRY_COLUMNS) {
+            for (int i = 0; i < rowCount; i++, out += 4) {
+                std::memcpy(out, (const unsigned char*)&rows[i] + c.offset, 4);
+            }
+        }
+        unsigned count = (unsigned)rowCount;
+        std::fwrite(&count, sizeof(count), 1, file);
+        std::fwrite(columns.get(), 1, out - columns.get(), file);
+        written += rowCount;
+        rowCount = 0;
+    }
+};
+
+// Converts a telemetry file to CSV with a header row. Works from the column
+// list stored in the file, so it also reads files with other columns.
+inline bool telemetryToCsv(const char* inPath, const char* outPath) {
+    FILE* in = std::fopen(inPath, "rb");
+    if (!in) return false;
+    FILE* out = std::fopen(outPath, "w");
+    if (!out) {
+        std::fclose(in);
+        return false;
+    }
+
+    bool ok = false;
+    char magic[4];
+    unsigned header[2];
+    std::vector<char> types;
+    if (std::fread(magic, 1, 4, in) == 4 && std::memcmp(magic, "SMTL", 4) == 0
+        && std::fread(header, sizeof(header), 1, in) == 1 && header[0] == TELEMETRY_VERSION) {
+        ok = true;
+        for (unsigned c = 0; c < header[1] && ok; c++) {
+            unsigned char meta[2];
+            char name[256];
+            ok = std::fread(meta, 1, 2, in) == 2 && std::fread(name, 1, meta[1], in) == meta[1];
+            name[ok ? meta[1] : 0] = 0;
+            types.push_back((char)meta[0]);
+            std::fprintf(out, c ? ",%s" : "%s", name);
+        }
+        std::fprintf(out, "\n");
+    }
+
+    std::vector<unsigned char> block;
+    unsigned count;
+    while (ok && std::fread(&count, sizeof(count), 1, in) == 1) {
+        block.resize((size_t)count * 4 * types.size());
+        if (std::fread(block.data(), 1, block.size(), in) != block.size()) {
+            ok = false; // Truncated, e.g. the game did not exit cleanly
+            break;
+        }
+        for (unsigned row = 0; row < count; row++) {
+            for (size_t c = 0; c < types.size(); c++) {
+                const unsigned char* p = block.data() + (c * count + row) * 4;
+                if (c) std::fputc(',', out);
+                if (types[c] == 'f') { float v; std::memcpy(&v, p, 4); std::fprintf(out, "%g", v); }
+                else if (types[c] == 'i') { int v; std::memcpy(&v, p, 4); std::fprintf(out, "%d", v); }
+                else { unsigned v; std::memcpy(&v, p, 4); std::fprintf(out, "%u", v); }
+            }
+            std::fputc('\n', out);
+        }
+    }
+
+    std::fclose(in);
+    return std::fclose(out) == 0 && ok;
+}
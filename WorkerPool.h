@@ -0,0 +1,105 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+// A unit of work for WorkerPool. Plain function pointer + context so that
+// dispatching a frame's jobs never allocates.
+struct Job {
+    void (*fn)(void* ctx);
+    void* ctx;
+};
+
+// Fixed set of worker threads that execute a batch of jobs together with the
+// calling thread. run() returns once every job of the batch has finished.
+// With zero workers the jobs simply run inline, in order, on the caller.
+class WorkerPool {
+public:
+    ~WorkerPool() { stop(); }
+
+    void start(int workerCount) {
+        stop();
+        quit = false;
+        unsigned current = generation;
+        for (int i = 0; i < workerCount; i++) {
+            threads.emplace_back([this, current] { workerLoop(current); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+        threads.clear();
+    }
+
+    int workerCount() const { return (int)threads.size(); }
+
+    void run(const Job* batch, int count) {
+        if (count <= 0) return;
+        if (threads.empty()) {
+            for (int i = 0; i < count; i++) batch[i].fn(batch[i].ctx);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs = batch;
+            jobCount = count;
+            next = 0;
+            finishedWorkers = 0;
+            generation++;
+        }
+        wake.notify_all();
+
+        runJobs();
+
+        // Every worker takes part in every batch, even if only to find `next`
+        // exhausted, so none of them can still be claiming from this batch
+        // once the following one is published.
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return finishedWorkers == (int)threads.size(); });
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const Job* jobs = nullptr;
+    int jobCount = 0;
+    std::atomic<int> next{ 0 };
+    int finishedWorkers = 0;
+    unsigned generation = 0;
+    bool quit = false;
+
+    void runJobs() {
+        for (;;) {
+            int i = next.fetch_add(1);
+            if (i >= jobCount) return;
+            jobs[i].fn(jobs[i].ctx);
+        }
+    }
+
+    void workerLoop(unsigned seen) {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+            }
+            runJobs();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finishedWorkers++;
+            }
+            done.notify_one();
+        }
+    }
+};
@@ -1,1026 +1,3853 @@
-﻿#include <SDL.h>
-#include <vector>
-#include <cmath>
-#include <string>
-#include <algorithm>
-#include <iostream>
-#include <ctime>
-
-const float PI = 3.14159265359f;
-int WINDOW_WIDTH = 1024;
-int WINDOW_HEIGHT = 768;
-
-struct Vec2 {
-    float x, y;
-};
-
-struct Color {
-    Uint8 r, g, b, a;
-};
-
-const Color COL_BG_DARK = { 26, 32, 44, 255 };
-const Color COL_RED_500 = { 239, 68, 68, 255 };
-const Color COL_YELLOW_400 = { 250, 204, 21, 255 };
-const Color COL_BLUE_500 = { 59, 130, 246, 255 };
-const Color COL_WHITE = { 255, 255, 255, 255 };
-const Color COL_ORANGE = { 249, 115, 22, 255 };
-const Color COL_PURPLE = { 147, 51, 234, 255 };
-const Color COL_SKIN = { 190, 140, 100, 255 };
-const int WINDUP_FRAMES = 8;
-const float SMASH_SPEED = 0.6f;
-
-int calculateFlightFrames(float speed, float threshold = 0.05f) {
-    //if (speed >= 1.0f) return 1;
-    //if (speed <= 0.0f) return 999;
-
-    return (int)std::ceil(std::log(threshold) / std::log(1.0f - speed));
-}
-
-float randomFloat(float min, float max) {
-    return min + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (max - min)));
-}
-
-float dist(Vec2 a, Vec2 b) {
-    return std::sqrt(std::pow(a.x - b.x, 2) + std::pow(a.y - b.y, 2));
-}
-
-class Renderer {
-public:
-    SDL_Renderer* renderer;
-    float camZoom = 1.0f;
-    float shakeX = 0.0f;
-    float shakeY = 0.0f;
-    int screenW, screenH;
-
-    Renderer(SDL_Renderer* r, int w, int h) : renderer(r), screenW(w), screenH(h) {}
-
-    Vec2 transform(float x, float y) {
-        float cx = screenW / 2.0f;
-        float cy = screenH / 2.0f;
-        // Zoom around center
-        float tx = (x - cx) * camZoom + cx;
-        float ty = (y - cy) * camZoom + cy;
-        return { tx + shakeX, ty + shakeY };
-    }
-
-    void setColor(Color c) {
-        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
-    }
-
-    void fillCircle(float x, float y, float radius, Color c) {
-        Vec2 center = transform(x, y);
-        float r = radius * camZoom;
-
-        const int segments = 30;
-        SDL_Vertex vertices[segments + 1];
-
-        vertices[0].position = { center.x, center.y };
-        vertices[0].color = { c.r, c.g, c.b, c.a };
-        vertices[0].tex_coord = { 0, 0 };
-
-        for (int i = 0; i < segments; i++) {
-            float angle = 2.0f * PI * i / segments;
-            vertices[i + 1].position = {
-                center.x + std::cos(angle) * r,
-                center.y + std::sin(angle) * r
-            };
-            vertices[i + 1].color = { c.r, c.g, c.b, c.a };
-            vertices[i + 1].tex_coord = { 0, 0 };
-        }
-
-        int indices[segments * 3];
-        for (int i = 0; i < segments; i++) {
-            indices[i * 3] = 0;
-            indices[i * 3 + 1] = i + 1;
-            indices[i * 3 + 2] = (i == segments - 1) ? 1 : i + 2;
-        }
-
-        SDL_RenderGeometry(renderer, NULL, vertices, segments + 1, indices, segments * 3);
-    }
-
-    void drawThickLine(float x1, float y1, float x2, float y2, float width, Color c) {
-        Vec2 p1 = transform(x1, y1);
-        Vec2 p2 = transform(x2, y2);
-        float w = width * camZoom * 0.5f;
-
-        float dx = p2.x - p1.x;
-        float dy = p2.y - p1.y;
-        float len = std::sqrt(dx * dx + dy * dy);
-        if (len == 0) return;
-
-        float nx = -dy / len * w;
-        float ny = dx / len * w;
-
-        SDL_Vertex v[4];
-
-        for (int i = 0; i < 4; i++) v[i].color = { c.r, c.g, c.b, c.a };
-
-        v[0].position = { p1.x + nx, p1.y + ny };
-        v[1].position = { p1.x - nx, p1.y - ny };
-        v[2].position = { p2.x - nx, p2.y - ny };
-        v[3].position = { p2.x + nx, p2.y + ny };
-
-        int indices[] = { 0, 1, 2, 0, 2, 3 };
-        SDL_RenderGeometry(renderer, NULL, v, 4, indices, 6);
-    }
-
-    void drawQuadraticBezier(Vec2 start, Vec2 control, Vec2 end, float width, Color c) {
-        int segments = 30;
-        Vec2 prev = start;
-        for (int i = 1; i <= segments; i++) {
-            float t = (float)i / segments;
-            float invT = 1.0f - t;
-            // B(t) = (1-t)^2 * P0 + 2(1-t)t * P1 + t^2 * P2
-            float x = invT * invT * start.x + 2 * invT * t * control.x + t * t * end.x;
-            float y = invT * invT * start.y + 2 * invT * t * control.y + t * t * end.y;
-            Vec2 curr = { x, y };
-            drawThickLine(prev.x, prev.y, curr.x, curr.y, width, c);
-            prev = curr;
-        }
-    }
-
-    void drawPolygon(float x, float y, const std::vector<Vec2>& points, float rotation, float scale, Color c) {
-        Vec2 center = transform(x, y);
-        float s = scale * camZoom;
-
-        std::vector<SDL_Vertex> verts;
-        verts.push_back({ {center.x, center.y}, {c.r, c.g, c.b, c.a}, {0,0} });
-
-        for (const auto& pt : points) {
-            float rx = pt.x * std::cos(rotation) - pt.y * std::sin(rotation);
-            float ry = pt.x * std::sin(rotation) + pt.y * std::cos(rotation);
-            verts.push_back({ {center.x + rx * s, center.y + ry * s}, {c.r, c.g, c.b, c.a}, {0,0} });
-        }
-
-        int n = points.size();
-        std::vector<int> indices;
-        for (int i = 0; i < n; i++) {
-            indices.push_back(0);
-            indices.push_back(i + 1);
-            indices.push_back((i == n - 1) ? 1 : i + 2);
-        }
-        SDL_RenderGeometry(renderer, NULL, verts.data(), verts.size(), indices.data(), indices.size());
-    }
-
-    void drawNumber(int number, float x, float y, float size, Color c) {
-        std::string s = std::to_string(number);
-        float currX = x;
-        for (char ch : s) {
-            float w = size *0.6f;
-            float h = size;
-
-            auto line = [&](float x1, float y1, float x2, float y2) {
-                drawThickLine(currX + x1 * w, y + y1 * h, currX + x2 * w, y + y2 * h, 3, c);
-            };
-
-            if (strchr("02356789", ch)) line(0, 0, 1, 0); // Top
-            if (strchr("2345689", ch))  line(0, 0.5, 1, 0.5); // Mid
-            if (strchr("0235689", ch))  line(0, 1, 1, 1); // Bot
-            if (strchr("045689", ch))   line(0, 0, 0, 0.5); // TopLeft
-            if (strchr("01234789", ch)) line(1, 0, 1, 0.5); // TopRight
-            if (strchr("0268", ch))     line(0, 0.5, 0, 1); // BotLeft
-            if (strchr("013456789", ch))line(1, 0.5, 1, 1); // BotRight
-
-            currX += w + 10;
-        }
-    }
-
-    void drawText(std::string text, float x, float y, float size, Color c) {
-
-    }
-};
-
-enum EnemyType { CRATE, SPIKE, HEX };
-
-struct Enemy {
-    float x, y;
-    float size;
-    float speed;
-    float vx;
-    float swayOffset, swaySpeed, swayAmplitude;
-    float rotation, rotSpeed;
-    EnemyType type;
-    Color color;
-    bool active;
-};
-
-struct Particle {
-    float x, y;
-    float vx, vy;
-    float life; // 0.0 - 1.0
-    float size;
-    Color color;
-    float decay;
-    std::vector<Vec2> lightningPath;
-    int type; // 0: Normal, 1: Lightning, 2: Debris, 3: Spark
-    float w, h; // For Debris
-    float rotation, vRot;
-};
-
-struct FloatingText {
-    float x, y;
-    int value; // Simplified to just numbers for this renderer
-    float vy;
-    float life;
-    Color color;
-};
-
-struct Explosion {
-    float x, y;
-    float life;
-    float rotation;
-    float scale;
-};
-
-struct Shockwave {
-    float x, y;
-    float radius;
-    float maxRadius;
-    float alpha;
-    float width;
-    Color color;
-};
-
-
-enum GameState { MENU, PLAYING, GAME_OVER };
-GameState gameState = MENU;
-int score = 0;
-float health = 100.0f;
-int level = 1;
-long frames = 0;
-float shakeIntensity = 0;
-float flashIntensity = 0;
-float camZoom = 1.0f;
-
-struct Player {
-    float x, y;
-    float width = 40, height = 60;
-    Color color = COL_BLUE_500;
-} player;
-
-struct Mouse {
-    int x, y;
-    bool clicked;
-} mouse;
-SDL_Texture* playerTexture = nullptr;
-Vec2 leftArm = { 0,0 }, rightArm = { 0,0 };
-enum PunchState { IDLE, WINDUP, SMASH, HOLD, RECOVER };
-PunchState punchState = IDLE;
-int punchTimer = 0;
-Vec2 punchTarget = { 0,0 };
-Enemy* lockedEnemy = nullptr;
-int hitStop = 0;
-bool hasSmashImpacted = false;
-
-std::vector<Enemy> enemies;
-std::vector<Particle> particles;
-std::vector<Shockwave> shockwaves;
-std::vector<Explosion> explosions;
-std::vector<FloatingText> floatingTexts;
-
-void initGame() {
-    score = 0;
-    health = 100;
-    level = 1;
-    enemies.clear();
-    particles.clear();
-    shockwaves.clear();
-    explosions.clear();
-    floatingTexts.clear();
-    player.x = WINDOW_WIDTH / 2.0f;
-    player.y = WINDOW_HEIGHT - 100.0f;
-    punchState = IDLE;
-    frames = 0;
-}
-
-void spawnEnemy() {
-    float size = randomFloat(30, 70);
-    int typeRoll = rand() % 3;
-    EnemyType type = (EnemyType)typeRoll;
-    Color c;
-    if (type == CRATE) c = { 217, 119, 6, 255 }; // Wood
-    else if (type == SPIKE) c = { 239, 68, 68, 255 }; // Red
-    else c = { 139, 92, 246, 255 }; // Purple
-
-    float speedBonus = std::min(5.0f, score / 3000.0f);
-
-    Enemy e;
-    e.x = randomFloat(size, WINDOW_WIDTH - size);
-    e.y = -size;
-    e.size = size;
-    e.speed = randomFloat(2, 4) + speedBonus;
-    e.vx = (randomFloat(0, 1) - 0.5f) * 4.0f;
-    e.swayOffset = randomFloat(0, PI * 2);
-    e.swaySpeed = 0.05f + randomFloat(0, 0.05f);
-    e.rotation = 0;
-    e.rotSpeed = (randomFloat(0, 1) - 0.5f) * 0.1f;
-    e.swayAmplitude = 7.0f;
-    e.type = type;
-    e.color = c;
-    e.active = true;
-    enemies.push_back(e);
-}
-
-void createParticles(float x, float y, Color c, int count, float scale = 1.0f) {
-    for (int i = 0; i < count; i++) {
-        Particle p;
-        float angle = randomFloat(0, PI * 2);
-        float speed = randomFloat(1, 4) * scale;
-        p.x = x; p.y = y;
-        p.vx = std::cos(angle) * speed;
-        p.vy = std::sin(angle) * speed;
-        p.life = 1.0f;
-        p.color = c;
-        p.size = randomFloat(2, 7);
-        p.decay = 0.03f;
-        p.type = 0; // Normal
-        particles.push_back(p);
-    }
-}
-
-void createDebris(float x, float y, Color c, int count, float scale) {
-    for (int i = 0; i < count; i++) {
-        Particle p;
-        float angle = randomFloat(0, PI * 2);
-        float force = randomFloat(5, 15) * scale;
-        p.x = x; p.y = y;
-        p.vx = std::cos(angle) * force;
-        p.vy = std::sin(angle) * force;
-        p.rotation = randomFloat(0, PI);
-        p.vRot = (randomFloat(0, 1) - 0.5f) * 0.8f;
-        p.life = 1.0f;
-        p.color = c;
-        p.w = randomFloat(4, 16) * scale;
-        p.h = randomFloat(4, 16) * scale;
-        p.type = 2; // Debris
-        particles.push_back(p);
-    }
-}
-
-void triggerPunch() {
-    punchState = WINDUP;
-    punchTimer = 0;
-    hasSmashImpacted = false;
-    lockedEnemy = nullptr;
-    float closestDist = 9999.0f;
-
-    for (auto& e : enemies) {
-        if (!e.active) continue;
-        float d = dist({ (float)mouse.x, (float)mouse.y }, { e.x, e.y });
-        if (d < e.size + 100 && d < closestDist) {
-            closestDist = d;
-            lockedEnemy = &e;
-        }
-    }
-
-    if (lockedEnemy) {
-
-        int flightFrames = calculateFlightFrames(SMASH_SPEED);
-        int totalPredictionFrames = WINDUP_FRAMES + flightFrames;
-
-        float simX = lockedEnemy->x;
-        float simY = lockedEnemy->y;
-        float simVx = lockedEnemy->vx;
-
-        for (int i = 1; i <= totalPredictionFrames; i++) {
-            long simFrame = frames + i;
-
-            simY += lockedEnemy->speed;
-
-            float simWind = std::sin(simFrame * lockedEnemy->swaySpeed + lockedEnemy->swayOffset) * lockedEnemy->swayAmplitude;
-
-            simX += simVx + simWind;
-
-            float margin = lockedEnemy->size / 2.0f;
-            if (simX < margin) {
-                simX = margin;
-                simVx *= -1;
-            }
-            else if (simX > WINDOW_WIDTH - margin) {
-                simX = WINDOW_WIDTH - margin;
-                simVx *= -1;
-            }
-        }
-        punchTarget.x = simX;
-        punchTarget.y = simY;
-    }
-    else {
-        punchTarget.x = (float)mouse.x;
-        punchTarget.y = (float)mouse.y;
-    }
-}
-
-void triggerImpact(float x, float y, float scale) {
-    // Level specific effects
-    if (level == 1) {
-        shakeIntensity = 10;
-    }
-    else if (level == 2) {
-        shockwaves.push_back({ x, y, 20, 15, 1.0f, 30, COL_ORANGE });
-        createParticles(x, y, COL_ORANGE, 20);
-        shakeIntensity = 25;
-    }
-    else if (level >= 3) {
-        shockwaves.push_back({ x, y, 30, 25, 1.0f, 10, COL_YELLOW_400 });
-        // Sparks
-        for (int i = 0; i < 10; i++) {
-            Particle p;
-            float angle = randomFloat(0, PI * 2);
-            float spd = randomFloat(10, 25);
-            p.x = x; p.y = y;
-            p.vx = std::cos(angle) * spd; p.vy = std::sin(angle) * spd;
-            p.life = 1.0f; p.type = 3; p.color = COL_WHITE;
-            p.w = 3 * scale; // width
-            particles.push_back(p);
-        }
-        shakeIntensity = 40;
-        camZoom = 1.4f;
-        if (level == 4) {
-            flashIntensity = 0.8f;
-            camZoom = 1.6f;
-            shockwaves.push_back({ x, y, 10, 40, 1.0f, 20, COL_PURPLE });
-        }
-    }
-}
-
-void checkCollision(float x1, float x2, float y) {
-    float centerX = (x1 + x2) / 2;
-    float distBetweenGloves = std::abs(x2 - x1);
-    float scale = 1.0f + (level - 1) * 0.5f;
-    float gloveReach = 44 * scale;
-
-    if (distBetweenGloves <= gloveReach * 2 ) {
-        if (!hasSmashImpacted) {
-            triggerImpact(centerX, y, scale);
-            hasSmashImpacted = true;
-        }
-    }
-
-    int hitCount = 0;
-    for (auto& e : enemies) {
-        if (!e.active) continue;
-        float killWidth = 44 * scale;
-        // AABB Collision
-        if (e.x > centerX - killWidth && e.x < centerX + killWidth &&
-            e.y > y - 80 * scale && e.y < y + 80 * scale) {
-
-            e.active = false;
-            int pts = (int)(e.size * scale * 2);
-            score += pts;
-            hitCount++;
-
-            createDebris(e.x, e.y, e.color, 8 + level * 4, scale);
-            floatingTexts.push_back({ e.x, e.y, pts, -2.0f, 1.0f, COL_YELLOW_400 });
-
-            if (level >= 2) hitStop = 4;
-        }
-    }
-
-    if (hitCount > 0) {
-        shakeIntensity += 5 * hitCount;
-    }
-}
-
-void update() {
-    if (gameState != PLAYING) return;
-    if (hitStop > 0) { hitStop--; return; }
-
-    frames++;
-
-    if (shakeIntensity > 0) shakeIntensity *= 0.85f;
-    if (shakeIntensity < 0.5f) shakeIntensity = 0;
-    if (flashIntensity > 0) flashIntensity -= 0.1f;
-    if (camZoom > 1.0f) camZoom -= 0.05f;
-    if (camZoom < 1.0f) camZoom = 1.0f;
-
-    int newLevel = std::min(4, (score / 1000) + 1);
-    if (newLevel > level) {
-        level = newLevel;
-        shakeIntensity = 30;
-        flashIntensity = 0.5f;
-    }
-
-    player.x = (float)mouse.x;
-    if (player.x < 20) player.x = 20;
-    if (player.x > WINDOW_WIDTH - 20) player.x = WINDOW_WIDTH - 20;
-
-    int spawnRate = std::max(10, 60 - (score / 100));
-    if (frames % spawnRate == 0) spawnEnemy();
-
-    for (auto& e : enemies) {
-        if (!e.active) continue;
-
-        e.y += e.speed;
-        float currentWind = std::sin(frames * e.swaySpeed + e.swayOffset) * e.swayAmplitude;
-        e.x += e.vx + currentWind;
-
-        if (e.x < e.size / 2) {
-            e.x = e.size / 2;
-            e.vx *= -1;
-        }
-        if (e.x > WINDOW_WIDTH - e.size / 2) {
-            e.x = WINDOW_WIDTH - e.size / 2;
-            e.vx *= -1;
-        }
-
-        e.rotation += e.rotSpeed;
-
-        if (dist({ e.x, e.y }, { player.x, player.y - player.height }) < e.size / 2 + player.width / 2) {
-            e.active = false;
-            health -= 20;
-            createDebris(e.x, e.y, e.color, 10, 1.0f);
-            shakeIntensity = 15;
-            flashIntensity = 0.4f;
-            if (health <= 0) gameState = GAME_OVER;
-        }
-
-        bool canBlock = (punchState == IDLE);
-
-        if (canBlock) {
-            float currentScale = 1.0f + (level - 1) * 0.5f;
-            float gloveRadius = 30.0f * currentScale;
-
-            bool hitLeft = dist({ e.x, e.y }, { leftArm.x, leftArm.y }) < (e.size / 2 + gloveRadius);
-            bool hitRight = dist({ e.x, e.y }, { rightArm.x, rightArm.y }) < (e.size / 2 + gloveRadius);
-
-            if (hitLeft || hitRight) {
-                e.active = false;
-                createParticles(e.x, e.y, { 220, 220, 220, 255 }, 10, 1.2f);
-                shakeIntensity = 5;
-                score += 10;
-                continue;
-            }
-        }
-        if (e.y > WINDOW_HEIGHT + e.size / 2) e.active = false;
-    }
-
-    enemies.erase(std::remove_if(enemies.begin(), enemies.end(), [](const Enemy& e) { return !e.active; }), enemies.end());
-
-    for (auto& p : particles) {
-        if (p.type == 2) {
-            p.x += p.vx; p.y += p.vy;
-            p.rotation += p.vRot;
-            p.vy += 0.4f;
-            p.life -= 0.015f;
-            if (p.y > WINDOW_HEIGHT || p.y < 0 || p.x > WINDOW_WIDTH || p.x < 0) { p.life = 0; }
-        }
-        else if (p.type == 3) { // Spark
-            p.x += p.vx; p.y += p.vy;
-            p.life -= 0.05f;
-        }
-        else {
-            p.x += p.vx; p.y += p.vy;
-            p.life -= p.decay;
-        }
-    }
-    particles.erase(std::remove_if(particles.begin(), particles.end(), [](const Particle& p) { return p.life <= 0; }), particles.end());
-
-    // Update Shockwaves
-    for (auto& s : shockwaves) {
-        s.radius += s.maxRadius; // actually using maxRadius as speed storage here
-        s.width *= 0.8f;
-        s.alpha -= 0.05f;
-    }
-    shockwaves.erase(std::remove_if(shockwaves.begin(), shockwaves.end(), [](const Shockwave& s) { return s.alpha <= 0; }), shockwaves.end());
-
-    // Update Texts
-    for (auto& t : floatingTexts) {
-        t.y += t.vy;
-        t.vy *= 0.9f;
-        t.life -= 0.02f;
-    }
-    floatingTexts.erase(std::remove_if(floatingTexts.begin(), floatingTexts.end(), [](const FloatingText& t) { return t.life <= 0; }), floatingTexts.end());
-
-    Vec2 shoulderL = { player.x - 20, player.y - 40 };
-    Vec2 shoulderR = { player.x + 20, player.y - 40 };
-
-    if (punchState == IDLE) {
-        float floatY = std::sin(frames * 0.1f) * 5.0f;
-        leftArm = { shoulderL.x - 40, shoulderL.y + 20 + floatY };
-        rightArm = { shoulderR.x + 40, shoulderR.y + 20 + floatY };
-    }
-    else if (punchState == WINDUP) {
-        punchTimer++;
-        float tx = punchTarget.x;
-        float ty = punchTarget.y;
-
-        leftArm.x += (tx - 250 - leftArm.x) * 0.25f;
-        leftArm.y += (ty - leftArm.y) * 0.25f;
-        rightArm.x += (tx + 250 - rightArm.x) * 0.25f;
-        rightArm.y += (ty - rightArm.y) * 0.25f;
-
-        if (punchTimer > WINDUP_FRAMES) { punchState = SMASH; punchTimer = 0; }
-    }
-    else if (punchState == SMASH) {
-        punchTimer++;
-        float scale = 1.0f + (level - 1) * 0.5f;
-        float reach = 36 * scale;
-        float speed = SMASH_SPEED;
-
-        float txL = punchTarget.x - reach;
-        float txR = punchTarget.x + reach;
-
-        leftArm.x += (txL - leftArm.x) * speed;
-        leftArm.y += (punchTarget.y - leftArm.y) * speed;
-        rightArm.x += (txR - rightArm.x) * speed;
-        rightArm.y += (punchTarget.y - rightArm.y) * speed;
-
-        if (leftArm.x > punchTarget.x - reach) leftArm.x = punchTarget.x - reach;
-        if (rightArm.x < punchTarget.x + reach) rightArm.x = punchTarget.x + reach;
-
-        if (std::abs(rightArm.x - leftArm.x) <= reach * 2 + 15) {
-            checkCollision(leftArm.x, rightArm.x, punchTarget.y);
-        }
-
-        if (punchTimer > 5) { punchState = HOLD; punchTimer = 0; }
-
-    }
-    else if (punchState == HOLD) {
-        punchTimer++;
-        if (punchTimer > 6) { punchState = RECOVER; punchTimer = 0; }
-    }
-    else if (punchState == RECOVER) {
-        punchTimer++;
-        float floatY = std::sin(frames * 0.1f) * 5.0f;
-
-        float targetXL = shoulderL.x - 40;
-        float targetYL = shoulderL.y + 20 + floatY;
-        float targetXR = shoulderR.x + 40;
-        float targetYR = shoulderR.y + 20 + floatY;
-
-        leftArm.x += (targetXL - leftArm.x) * 0.2f;
-        leftArm.y += (targetYL - leftArm.y) * 0.2f;
-        rightArm.x += (targetXR - rightArm.x) * 0.2f;
-        rightArm.y += (targetYR - rightArm.y) * 0.2f;
-
-        if (punchTimer > 10) {
-            punchState = IDLE;
-            leftArm = { targetXL, targetYL };
-            rightArm = { targetXR, targetYR };
-        }
-    }
-}
-
-void drawGlove(Renderer& r, float x, float y, bool isLeft) {
-    float s = 1.0f + (level - 1) * 0.3f;
-
-    SDL_SetRenderDrawBlendMode(r.renderer, SDL_BLENDMODE_ADD);
-    Color auraColor = COL_RED_500;
-    if (level == 2) auraColor = COL_ORANGE;
-    if (level == 3) auraColor = COL_YELLOW_400;
-    if (level == 4) auraColor = COL_PURPLE;
-
-    if (level >= 2) {
-        float pulse = std::sin(frames * 0.2f) * 5.0f;
-        auraColor.a = 60;
-        r.fillCircle(x, y, (40 + pulse) * s, auraColor);
-    }
-    SDL_SetRenderDrawBlendMode(r.renderer, SDL_BLENDMODE_BLEND);
-
-    Color gc = COL_RED_500;
-    if (level == 2) gc = COL_ORANGE;
-    if (level == 3) gc = COL_YELLOW_400;
-    if (level == 4) gc = COL_PURPLE;
-
-    float cuffOffsetX = isLeft ? -20 * s : 20 * s;
-
-    r.drawThickLine(
-        x + cuffOffsetX, y - 15 * s,
-        x + cuffOffsetX, y + 15 * s, 
-        12 * s,
-        COL_WHITE
-    );
-
-    float gloveOffsetX = isLeft ? 5 * s : -5 * s;
-    r.fillCircle(x + gloveOffsetX, y, 28 * s, gc);
-
-    float thumbX = isLeft ? 15 * s : -15 * s;
-    r.fillCircle(x + thumbX, y - 10 * s, 12 * s, gc);
-
-    r.fillCircle(x + gloveOffsetX, y - 10 * s, 8 * s, { 255, 255, 255, 80 });
-}
-
-void render(Renderer& r) {
-    SDL_SetRenderDrawBlendMode(r.renderer, SDL_BLENDMODE_NONE);
-    // Background
-    Color bg = COL_BG_DARK;
-    if (level == 2) bg = { 46, 16, 5, 255 };
-    if (level == 3) bg = { 30, 32, 16, 255 };
-    if (level == 4) bg = { 21, 5, 46, 255 };
-    r.setColor(bg);
-    SDL_RenderClear(r.renderer);
-
-    // Apply Camera
-    r.camZoom = camZoom;
-    if (shakeIntensity > 0) {
-        r.shakeX = (randomFloat(0, 1) - 0.5f) * shakeIntensity;
-        r.shakeY = (randomFloat(0, 1) - 0.5f) * shakeIntensity;
-    }
-    else {
-        r.shakeX = 0; r.shakeY = 0;
-    }
-
-    float screenFloorY = r.transform(0, player.y).y;
-
-    SDL_Rect floorRect;
-    floorRect.x = 0;
-    floorRect.y = (int)screenFloorY;
-    floorRect.w = WINDOW_WIDTH;
-    floorRect.h = WINDOW_HEIGHT;
-
-    SDL_SetRenderDrawColor(r.renderer, 20, 25, 40, 255);
-    SDL_RenderFillRect(r.renderer, &floorRect);
-    r.drawThickLine(0, player.y, WINDOW_WIDTH, player.y, 4, { 60, 70, 90, 255 });
-
-    //Additive Layer
-    SDL_SetRenderDrawBlendMode(r.renderer, SDL_BLENDMODE_ADD);
-
-    for (auto& s : shockwaves) {
-        Color c = s.color;
-        c.a = (Uint8)(s.alpha * 255);
-        r.fillCircle(s.x, s.y, s.radius, c);
-    }
-
-    for (auto& p : particles) {
-        Color c = p.color;
-        if (p.type == 3) { // Spark (Line)
-            c.a = (Uint8)(p.life * 255);
-            r.drawThickLine(p.x, p.y, p.x - p.vx * 2, p.y - p.vy * 2, p.w, c);
-        }
-        else if (p.type != 2) { // Not Debris
-            c.a = (Uint8)(p.life * 255);
-            r.fillCircle(p.x, p.y, p.size, c);
-        }
-    }
-
-    SDL_SetRenderDrawBlendMode(r.renderer, SDL_BLENDMODE_BLEND);
-
-    for (auto& p : particles) {
-        if (p.type == 2) {
-            std::vector<Vec2> shape = {
-                {-p.w / 2, -p.h / 2}, {p.w / 2, -p.h / 4}, {0, p.h / 2}, {-p.w / 2, p.h / 4}
-            };
-            r.drawPolygon(p.x, p.y, shape, p.rotation, 1.0f, p.color);
-        }
-    }
-
-    if (gameState == MENU) {
-        return;
-    }
-
-    for (auto& e : enemies) {
-        auto getRotatedPos = [&](float dx, float dy) -> Vec2 {
-            float rx = dx * std::cos(e.rotation) - dy * std::sin(e.rotation);
-            float ry = dx * std::sin(e.rotation) + dy * std::cos(e.rotation);
-            return { e.x + rx, e.y + ry };
-        };
-
-        if (e.type == CRATE) {
-            float hs = e.size / 2.0f;
-            std::vector<Vec2> boxShape = { {-hs,-hs}, {hs,-hs}, {hs,hs}, {-hs,hs} };
-
-            Color shadowCol = { 0, 0, 0, 80 };
-            r.drawPolygon(e.x + 10, e.y + 10, boxShape, e.rotation, 1.0f, shadowCol);
-
-            r.drawPolygon(e.x, e.y, boxShape, e.rotation, 1.0f, e.color);
-
-            Color strokeColor = { 120, 53, 15, 255 };
-            float thick = 3.0f;
-
-            Vec2 p1 = getRotatedPos(-hs, -hs);
-            Vec2 p2 = getRotatedPos(hs, -hs);
-            Vec2 p3 = getRotatedPos(hs, hs);
-            Vec2 p4 = getRotatedPos(-hs, hs);
-
-            r.drawThickLine(p1.x, p1.y, p2.x, p2.y, thick, strokeColor);
-            r.drawThickLine(p2.x, p2.y, p3.x, p3.y, thick, strokeColor);
-            r.drawThickLine(p3.x, p3.y, p4.x, p4.y, thick, strokeColor);
-            r.drawThickLine(p4.x, p4.y, p1.x, p1.y, thick, strokeColor);
-            r.drawThickLine(p1.x, p1.y, p3.x, p3.y, thick, strokeColor);
-            r.drawThickLine(p2.x, p2.y, p4.x, p4.y, thick, strokeColor);
-        }
-        else if (e.type == HEX) {
-            std::vector<Vec2> hex;
-            for (int i = 0; i < 6; i++) {
-                float a = i * PI / 3.0f;
-                hex.push_back({ std::cos(a) * e.size / 1.5f, std::sin(a) * e.size / 1.5f });
-            }
-
-            r.drawPolygon(e.x + 10, e.y + 10, hex, e.rotation, 1.0f, { 0, 0, 0, 80 });
-
-            r.drawPolygon(e.x, e.y, hex, e.rotation, 1.0f, e.color);
-
-            Color strokeColor = { 76, 29, 149, 255 }; // #4c1d95
-            for (int i = 0; i < 6; i++) {
-                float a1 = i * PI / 3.0f;
-                float a2 = (i + 1) * PI / 3.0f;
-                Vec2 p1 = getRotatedPos(std::cos(a1) * e.size / 1.5f, std::sin(a1) * e.size / 1.5f);
-                Vec2 p2 = getRotatedPos(std::cos(a2) * e.size / 1.5f, std::sin(a2) * e.size / 1.5f);
-                r.drawThickLine(p1.x, p1.y, p2.x, p2.y, 3.0f, strokeColor);
-            }
-        }
-        else {
-            std::vector<Vec2> spikes;
-            int numSpikes = 8;
-            float innerR = e.size / 2.0f;
-            float outerR = e.size / 1.3f;
-
-            for (int i = 0; i < numSpikes * 2; i++) {
-                float angle = i * PI / numSpikes;
-                float r_val = (i % 2 == 0) ? outerR : innerR;
-                spikes.push_back({
-                    std::cos(angle) * r_val,
-                    std::sin(angle) * r_val
-                    });
-            }
-
-            r.drawPolygon(e.x + 10, e.y + 10, spikes, e.rotation, 1.0f, { 0, 0, 0, 80 });
-
-            r.drawPolygon(e.x, e.y, spikes, e.rotation, 1.0f, e.color);
-
-            Color strokeColor = { 127, 29, 29, 255 };
-
-            for (size_t i = 0; i < spikes.size(); i++) {
-                size_t next = (i + 1) % spikes.size();
-                Vec2 p1 = getRotatedPos(spikes[i].x, spikes[i].y);
-                Vec2 p2 = getRotatedPos(spikes[next].x, spikes[next].y);
-                r.drawThickLine(p1.x, p1.y, p2.x, p2.y, 2.0f, strokeColor);
-            }
-        }
-    }
-
-    if (lockedEnemy && lockedEnemy->active) {
-        float size = lockedEnemy->size + 20;
-        float angle = frames * 0.1f;
-
-        r.setColor({ 0, 255, 0, 255 });
-
-        float cx = lockedEnemy->x;
-        float cy = lockedEnemy->y;
-        float s = size / 2.0f;
-        float len = 15.0f;
-
-        std::vector<Vec2> reticle;
-        reticle.push_back({ -s, -s }); reticle.push_back({ s, -s });
-        reticle.push_back({ s, s });   reticle.push_back({ -s, s });
-
-        auto drawRotatedCorner = [&](float dx, float dy) {
-            float rx = dx * std::cos(angle) - dy * std::sin(angle);
-            float ry = dx * std::sin(angle) + dy * std::cos(angle);
-        };
-
-        Vec2 tl = r.transform(cx - s, cy - s);
-        Vec2 tr = r.transform(cx + s, cy - s);
-        Vec2 br = r.transform(cx + s, cy + s);
-        Vec2 bl = r.transform(cx - s, cy + s);
-
-        r.drawThickLine(cx - s, cy - s, cx + s, cy - s, 4, { 0, 255, 0, 255 });
-        r.drawThickLine(cx + s, cy - s, cx + s, cy + s, 4, { 0, 255, 0, 255 });
-        r.drawThickLine(cx + s, cy + s, cx - s, cy + s, 4, { 0, 255, 0, 255 });
-        r.drawThickLine(cx - s, cy + s, cx - s, cy - s, 4, { 0, 255, 0, 255 });
-    }
-
-    // Player
-    Vec2 shoulderL = { player.x - 15, player.y - 50 };
-    Vec2 shoulderR = { player.x + 15, player.y - 50 };
-
-    // Arms (Bezier)
-    Vec2 midL = { (shoulderL.x + leftArm.x) / 2 - 50, (shoulderL.y + leftArm.y) / 2 + 20 };
-    r.drawQuadraticBezier(shoulderL, midL, leftArm, 24, COL_SKIN);
-
-    Vec2 midR = { (shoulderR.x + rightArm.x) / 2 + 50, (shoulderR.y + rightArm.y) / 2 + 20 };
-    r.drawQuadraticBezier(shoulderR, midR, rightArm, 24, COL_SKIN);
-
-    if (playerTexture) {
-        int drawW = 1000;
-        int drawH = 1000;
-        SDL_Rect destRect;
-        Vec2 screenPos = r.transform(player.x, player.y);
-        destRect.x = (int)(screenPos.x - drawW / 2);
-        int manualOffsetY = 450;
-        destRect.y = (int)(screenPos.y - drawH + manualOffsetY);
-        destRect.w = drawW;
-        destRect.h = drawH;
-        SDL_RenderCopy(r.renderer, playerTexture, NULL, &destRect);
-    }
-    else {
-        r.fillCircle(player.x, player.y - 60, 30, COL_BLUE_500);
-    }
-
-    drawGlove(r, leftArm.x, leftArm.y, true);
-    drawGlove(r, rightArm.x, rightArm.y, false);
-
-    r.camZoom = 1.0f; r.shakeX = 0; r.shakeY = 0;
-    r.drawNumber(score, 20, 50, 25, COL_YELLOW_400);
-    r.drawNumber((int)std::max(0.0f, health), WINDOW_WIDTH - 150, 50, 25, COL_RED_500);
-
-    // Floating Text
-    for (auto& t : floatingTexts) {
-        Color c = t.color;
-        c.a = (Uint8)(t.life * 255); // Alpha fade not fully supported by drawNumber logic but works for blending
-        r.drawNumber(t.value, t.x, t.y, 20, c);
-    }
-
-    // Flash
-    if (flashIntensity > 0) {
-        SDL_SetRenderDrawBlendMode(r.renderer, SDL_BLENDMODE_BLEND);
-        SDL_SetRenderDrawColor(r.renderer, 255, 255, 255, (Uint8)(flashIntensity * 255));
-        SDL_Rect rect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
-        SDL_RenderFillRect(r.renderer, &rect);
-    }
-}
-
-// --- Main ---
-
-int main(int argc, char* argv[]) {
-    std::srand(std::time(nullptr));
-
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "SDL Init Failed: " << SDL_GetError() << std::endl;
-        return 1;
-    }
-
-    SDL_Window* window = SDL_CreateWindow("Smash Master - C++ SDL2",
-        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-        WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-
-    if (!window) return 1;
-
-    SDL_Renderer* sdlRenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-
-    SDL_SetRenderDrawBlendMode(sdlRenderer, SDL_BLENDMODE_BLEND);
-
-    Renderer r(sdlRenderer, WINDOW_WIDTH, WINDOW_HEIGHT);
-    SDL_Surface* tempSurface = SDL_LoadBMP("player.bmp");
-    if (tempSurface) {
-        Uint32 colKey = SDL_MapRGB(tempSurface->format, 255, 0, 255);
-        SDL_SetColorKey(tempSurface, SDL_TRUE, colKey);
-
-        playerTexture = SDL_CreateTextureFromSurface(sdlRenderer, tempSurface);
-        SDL_FreeSurface(tempSurface);
-    }
-    else {
-        std::cout << "failed finding player.bmp" << std::endl;
-    }
-    bool running = true;
-    SDL_Event event;
-
-    initGame();
-    gameState = PLAYING;
-
-    while (running) {
-        // Input
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) running = false;
-            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
-                WINDOW_WIDTH = event.window.data1;
-                WINDOW_HEIGHT = event.window.data2;
-                r.screenW = WINDOW_WIDTH; r.screenH = WINDOW_HEIGHT;
-                player.y = WINDOW_HEIGHT - 100;
-            }
-            if (event.type == SDL_MOUSEMOTION) {
-                mouse.x = event.motion.x;
-                mouse.y = event.motion.y;
-            }
-            if (event.type == SDL_MOUSEBUTTONDOWN) {
-                if (gameState == MENU || gameState == GAME_OVER) {
-                    initGame();
-                    gameState = PLAYING;
-                }
-                else {
-                    if (punchState == IDLE) triggerPunch();
-                }
-            }
-        }
-
-        // Loop
-        if (gameState == PLAYING) {
-            update();
-        }
-
-        // Draw
-        render(r);
-
-        if (gameState == MENU) {
-            r.camZoom = 1.0f; r.shakeX = 0; r.shakeY = 0;
-            r.fillCircle(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2, 80, COL_RED_500);
-        }
-        if (gameState == GAME_OVER) {
-            r.camZoom = 1.0f; r.shakeX = 0; r.shakeY = 0;
-            // Darken
-            SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 200);
-            SDL_Rect rect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
-            SDL_RenderFillRect(sdlRenderer, &rect);
-
-            r.drawNumber(score, WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2, 60, COL_YELLOW_400);
-        }
-
-        SDL_RenderPresent(sdlRenderer);
-    }
-
-    SDL_DestroyRenderer(sdlRenderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
-
-    return 0;
+﻿#include <SDL.h>
+#include <vector>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <ctime>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <type_traits>
+#include "WorkerPool.h"
+#include "FrameArena.h"
+#include "ProcessStats.h"
+#include "FrameCapture.h"
+#include "AudioEngine.h"
+#include "Telemetry.h"
+#include "SoftRaster.h"
+#include "Simd.h"
+
+// Heap allocation counter for debug and benchmark builds (define SMASH_COUNT_ALLOCS).
+// Used to check that the render path does not allocate once warmed up.
+#if defined(_DEBUG) || defined(SMASH_COUNT_ALLOCS)
+#define SMASH_ALLOC_HOOK 1
+std::atomic<long> heapAllocations(0);
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+// Number of heap allocations so far, or -1 when the hook is compiled out.
+long allocationCount() {
+#ifdef SMASH_ALLOC_HOOK
+    return heapAllocations.load(std::memory_order_relaxed);
+#else
+    return -1;
+#endif
+}
+
+const float PI = 3.14159265359f;
+int WINDOW_WIDTH = 1024;
+int WINDOW_HEIGHT = 768;
+
+struct Vec2 {
+    float x, y;
+};
+
+struct Color {
+    Uint8 r, g, b, a;
+};
+
+const Color COL_BG_DARK = { 26, 32, 44, 255 };
+const Color COL_RED_500 = { 239, 68, 68, 255 };
+const Color COL_YELLOW_400 = { 250, 204, 21, 255 };
+const Color COL_BLUE_500 = { 59, 130, 246, 255 };
+const Color COL_WHITE = { 255, 255, 255, 255 };
+const Color COL_ORANGE = { 249, 115, 22, 255 };
+const Color COL_PURPLE = { 147, 51, 234, 255 };
+const Color COL_SKIN = { 190, 140, 100, 255 };
+const int WINDUP_FRAMES = 8;
+const float SMASH_SPEED = 0.6f;
+
+int calculateFlightFrames(float speed, float threshold = 0.05f) {
+    //if (speed >= 1.0f) return 1;
+    //if (speed <= 0.0f) return 999;
+
+    return (int)std::ceil(std::log(threshold) / std::log(1.0f - speed));
+}
+
+// Simulation RNG (xorshift32). It is part of the world state so that a restored
+// snapshot replays the same spawns and debris; purely visual randomness such as
+// camera shake uses rand() instead.
+Uint32 simRandom = 0x9E3779B9u;
+
+void seedRandom(Uint32 seed) {
+    simRandom = seed ? seed : 0x9E3779B9u;
+}
+
+// The overloads taking a state draw from another stream the same way, for
+// worlds that are not the globals (see Batch Simulation).
+Uint32 randomBits(Uint32& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int randomInt(Uint32& state, int n) {
+    return (int)(randomBits(state) % (Uint32)n);
+}
+
+float randomFloat(Uint32& state, float min, float max) {
+    return min + (max - min) * ((randomBits(state) >> 8) * (1.0f / 16777216.0f));
+}
+
+Uint32 randomBits() {
+    return randomBits(simRandom);
+}
+
+int randomInt(int n) {
+    return randomInt(simRandom, n);
+}
+
+float randomFloat(float min, float max) {
+    return randomFloat(simRandom, min, max);
+}
+
+float dist(Vec2 a, Vec2 b) {
+    return std::sqrt(std::pow(a.x - b.x, 2) + std::pow(a.y - b.y, 2));
+}
+
+// Swept tests for one tick of motion. Both objects move linearly over the
+// tick, p from p0 to p1 and the shape's centre from c0 to c1, so only their
+// relative motion matters. A zero-length sweep is the plain overlap test.
+
+// True if p comes closer than r to the centre at some point during the tick.
+bool sweptCircleHit(Vec2 p0, Vec2 p1, Vec2 c0, Vec2 c1, float r) {
+    float ax = p0.x - c0.x, ay = p0.y - c0.y;
+    float dx = (p1.x - c1.x) - ax, dy = (p1.y - c1.y) - ay;
+    float len2 = dx * dx + dy * dy;
+    float t = 0;
+    if (len2 > 0) t = std::min(1.0f, std::max(0.0f, -(ax * dx + ay * dy) / len2));
+    float cx = ax + dx * t, cy = ay + dy * t;
+    return cx * cx + cy * cy < r * r;
+}
+
+// True if p is strictly inside the box (half extents hw, hh) at some point during the tick.
+bool sweptBoxHit(Vec2 p0, Vec2 p1, Vec2 c0, Vec2 c1, float hw, float hh) {
+    float a[2] = { p0.x - c0.x, p0.y - c0.y };
+    float d[2] = { (p1.x - c1.x) - a[0], (p1.y - c1.y) - a[1] };
+    float h[2] = { hw, hh };
+    float tEnter = 0, tExit = 1;
+    for (int i = 0; i < 2; i++) {
+        if (d[i] == 0) {
+            if (a[i] <= -h[i] || a[i] >= h[i]) return false;
+            continue;
+        }
+        float t0 = (-h[i] - a[i]) / d[i];
+        float t1 = (h[i] - a[i]) / d[i];
+        if (t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+    }
+    return tEnter < tExit;
+}
+
+// Row-major 2x3 affine transform:
+// x' = a * x + b * y + tx
+// y' = c * x + d * y + ty
+struct Mat2x3 {
+    float a, b, tx;
+    float c, d, ty;
+};
+
+const Mat2x3 MAT_IDENTITY = { 1, 0, 0, 0, 1, 0 };
+
+struct ViewRect {
+    float minX, minY, maxX, maxY;
+
+    // Conservative: tests the circle's bounding box against the rectangle.
+    bool overlapsCircle(float x, float y, float radius) const {
+        return x + radius >= minX && x - radius <= maxX &&
+               y + radius >= minY && y - radius <= maxY;
+    }
+};
+
+// Maps world space (game coordinates) to screen space (window pixels).
+// Zoom pivots around the screen centre, shake is applied after zoom in screen pixels.
+struct Camera {
+    float zoom = 1.0f;
+    float shakeX = 0.0f;
+    float shakeY = 0.0f;
+    int screenW = 0, screenH = 0;
+
+    Mat2x3 viewMatrix() const {
+        float cx = screenW / 2.0f;
+        float cy = screenH / 2.0f;
+        return {
+            zoom, 0, cx - cx * zoom + shakeX,
+            0, zoom, cy - cy * zoom + shakeY
+        };
+    }
+
+    // World-space rectangle that ends up on screen with the current zoom and shake.
+    ViewRect visibleWorldRect() const {
+        Mat2x3 m = viewMatrix();
+        return {
+            (0 - m.tx) / m.a, (0 - m.ty) / m.d,
+            (screenW - m.tx) / m.a, (screenH - m.ty) / m.d
+        };
+    }
+};
+
+// Applies m to count interleaved (x, y) pairs in place.
+void transformPoints(float* xy, int count, const Mat2x3& m) {
+    int i = 0;
+#ifdef SMASH_SSE2
+    // Two points per register: (x0, y0, x1, y1)
+    const __m128 diag = _mm_setr_ps(m.a, m.d, m.a, m.d);
+    const __m128 cross = _mm_setr_ps(m.b, m.c, m.b, m.c);
+    const __m128 trans = _mm_setr_ps(m.tx, m.ty, m.tx, m.ty);
+    for (; i + 2 <= count; i += 2) {
+        __m128 p = _mm_loadu_ps(xy + i * 2);
+        __m128 swapped = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1));
+        p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, diag), _mm_mul_ps(swapped, cross)), trans);
+        _mm_storeu_ps(xy + i * 2, p);
+    }
+#endif
+    for (; i < count; i++) {
+        float x = xy[i * 2];
+        float y = xy[i * 2 + 1];
+        xy[i * 2] = m.a * x + m.b * y + m.tx;
+        xy[i * 2 + 1] = m.c * x + m.d * y + m.ty;
+    }
+}
+
+// Draw order. Layers from LAYER_HUD up are in screen space, the rest go through the camera.
+enum RenderLayer {
+    LAYER_BACKGROUND,
+    LAYER_EFFECTS,
+    LAYER_DEBRIS,
+    LAYER_SHADOWS,
+    LAYER_BODIES,
+    LAYER_OUTLINES,
+    LAYER_RETICLE,
+    LAYER_PLAYER,
+    LAYER_GLOVE_AURA,
+    LAYER_GLOVES,
+    LAYER_HUD,
+    LAYER_FLASH,
+    LAYER_OVERLAY
+};
+
+bool isWorldLayer(int layer) {
+    return layer < LAYER_HUD;
+}
+
+int blendSortIndex(SDL_BlendMode mode) {
+    if (mode == SDL_BLENDMODE_NONE) return 0;
+    if (mode == SDL_BLENDMODE_BLEND) return 1;
+    if (mode == SDL_BLENDMODE_ADD) return 2;
+    return 3;
+}
+
+// A run of geometry recorded with the same layer, blend mode and texture.
+// Vertex indices are local to the item.
+struct DrawItem {
+    Uint8 layer;
+    Uint8 blend;
+    Uint16 texture; // 0: untextured, otherwise Renderer::textures[texture - 1]
+    Uint32 depth;   // recording order within the queue
+    int firstVertex, vertexCount;
+    int firstIndex, indexCount;
+
+    // layer | blend | texture | depth, most significant first
+    Uint64 sortKey() const {
+        return ((Uint64)layer << 56) | ((Uint64)blend << 52) | ((Uint64)texture << 36) | depth;
+    }
+
+    bool sameState(const DrawItem& o) const {
+        return layer == o.layer && blend == o.blend && texture == o.texture;
+    }
+};
+
+// Records geometry as sortable draw items. Nothing reaches SDL until Renderer::submit().
+class RenderQueue {
+public:
+    std::vector<DrawItem> items;
+    std::vector<float> xy;
+    std::vector<float> uv;
+    std::vector<SDL_Color> colors;
+    std::vector<int> indices;
+    FrameArena arena;
+
+    DrawItem state = { LAYER_BACKGROUND, (Uint8)blendSortIndex(SDL_BLENDMODE_BLEND), 0, 0, 0, 0, 0, 0 };
+    SDL_BlendMode stateBlend = SDL_BLENDMODE_BLEND;
+
+    ViewRect worldRect = { 0, 0, 0, 0 };
+    ViewRect screenRect = { 0, 0, 0, 0 };
+
+    // Per-frame culling counters, see isVisible()
+    int drawnCount = 0;
+    int culledCount = 0;
+
+    // Starts a private queue that records against the same view as `frame`.
+    void beginRecording(const RenderQueue& frame) {
+        clear();
+        worldRect = frame.worldRect;
+        screenRect = frame.screenRect;
+        setLayer(LAYER_BACKGROUND);
+    }
+
+    // Concatenates another queue's items after this one's, keeping their order.
+    void append(const RenderQueue& other) {
+        int vertexBase = (int)colors.size();
+        int indexBase = (int)indices.size();
+        Uint32 depthBase = (Uint32)items.size();
+        for (DrawItem item : other.items) {
+            item.firstVertex += vertexBase;
+            item.firstIndex += indexBase;
+            item.depth += depthBase;
+            items.push_back(item);
+        }
+        xy.insert(xy.end(), other.xy.begin(), other.xy.end());
+        uv.insert(uv.end(), other.uv.begin(), other.uv.end());
+        colors.insert(colors.end(), other.colors.begin(), other.colors.end());
+        indices.insert(indices.end(), other.indices.begin(), other.indices.end());
+        drawnCount += other.drawnCount;
+        culledCount += other.culledCount;
+    }
+
+    void sortItems() {
+        std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) {
+            return a.sortKey() < b.sortKey();
+        });
+    }
+
+    // FNV-1a over the sorted stream exactly as Renderer::submit() would batch it.
+    // Each array is hashed as its own stream, so the result does not depend on
+    // how the geometry happened to be split into items.
+    Uint64 streamDigest() {
+        sortItems();
+        Uint64 hashes[5] = {};
+        auto mix = [&hashes](int stream, const void* data, size_t bytes) {
+            Uint64& hash = hashes[stream];
+            if (hash == 0) hash = 14695981039346656037ull;
+            const Uint8* p = (const Uint8*)data;
+            for (size_t i = 0; i < bytes; i++) {
+                hash ^= p[i];
+                hash *= 1099511628211ull;
+            }
+        };
+
+        int lastBatchState = -1;
+        int vertexBase = 0;
+        for (const DrawItem& item : items) {
+            int batchState = (isWorldLayer(item.layer) << 24) | (item.blend << 16) | item.texture;
+            if (batchState != lastBatchState) {
+                mix(0, &batchState, sizeof(batchState));
+                mix(0, &vertexBase, sizeof(vertexBase));
+                lastBatchState = batchState;
+            }
+            mix(1, &xy[item.firstVertex * 2], item.vertexCount * 2 * sizeof(float));
+            mix(2, &uv[item.firstVertex * 2], item.vertexCount * 2 * sizeof(float));
+            mix(3, &colors[item.firstVertex], item.vertexCount * sizeof(SDL_Color));
+            for (int i = 0; i < item.indexCount; i++) {
+                int index = indices[item.firstIndex + i] + vertexBase;
+                mix(4, &index, sizeof(index));
+            }
+            vertexBase += item.vertexCount;
+        }
+
+        Uint64 digest = 0;
+        for (Uint64 h : hashes) digest = digest * 31 + h;
+        return digest;
+    }
+
+    void clear() {
+        items.clear();
+        xy.clear();
+        uv.clear();
+        colors.clear();
+        indices.clear();
+        arena.reset();
+        drawnCount = 0;
+        culledCount = 0;
+    }
+
+    void setLayer(RenderLayer layer, SDL_BlendMode blend = SDL_BLENDMODE_BLEND) {
+        state.layer = (Uint8)layer;
+        state.blend = (Uint8)blendSortIndex(blend);
+        stateBlend = blend;
+    }
+
+    // Scratch memory valid until the queue is cleared for the next frame.
+    template<typename T>
+    Span<T> scratch(int count) {
+        return arena.alloc<T>(count);
+    }
+
+    // Bounding-circle test against the area visible in the current layer.
+    // Call before generating an entity's geometry; counts the result.
+    bool isVisible(float x, float y, float radius) {
+        const ViewRect& rect = isWorldLayer(state.layer) ? worldRect : screenRect;
+        if (rect.overlapsCircle(x, y, radius)) {
+            drawnCount++;
+            return true;
+        }
+        culledCount++;
+        return false;
+    }
+
+    // Returns the local index of the new vertex within the current item.
+    int pushVertex(float x, float y, Color c, float u = 0, float v = 0) {
+        DrawItem& item = currentItem();
+        xy.push_back(x);
+        xy.push_back(y);
+        uv.push_back(u);
+        uv.push_back(v);
+        colors.push_back({ c.r, c.g, c.b, c.a });
+        return item.vertexCount++;
+    }
+
+    void pushTriangle(int i0, int i1, int i2) {
+        DrawItem& item = items.back();
+        indices.push_back(i0);
+        indices.push_back(i1);
+        indices.push_back(i2);
+        item.indexCount += 3;
+    }
+
+    void fillRect(float x0, float y0, float x1, float y1, Color c) {
+        int base = pushVertex(x0, y0, c);
+        pushVertex(x1, y0, c);
+        pushVertex(x1, y1, c);
+        pushVertex(x0, y1, c);
+
+        pushTriangle(base, base + 1, base + 2);
+        pushTriangle(base, base + 2, base + 3);
+    }
+
+    void drawTexturedRect(Uint16 texture, float x0, float y0, float x1, float y1) {
+        state.texture = texture;
+        int base = pushVertex(x0, y0, COL_WHITE, 0, 0);
+        pushVertex(x1, y0, COL_WHITE, 1, 0);
+        pushVertex(x1, y1, COL_WHITE, 1, 1);
+        pushVertex(x0, y1, COL_WHITE, 0, 1);
+        state.texture = 0;
+
+        pushTriangle(base, base + 1, base + 2);
+        pushTriangle(base, base + 2, base + 3);
+    }
+
+    void fillCircle(float x, float y, float radius, Color c) {
+        const int segments = 30;
+
+        int center = pushVertex(x, y, c);
+        for (int i = 0; i < segments; i++) {
+            float angle = 2.0f * PI * i / segments;
+            pushVertex(x + std::cos(angle) * radius, y + std::sin(angle) * radius, c);
+        }
+
+        for (int i = 0; i < segments; i++) {
+            pushTriangle(center, center + i + 1, (i == segments - 1) ? center + 1 : center + i + 2);
+        }
+    }
+
+    void drawThickLine(float x1, float y1, float x2, float y2, float width, Color c) {
+        float w = width * 0.5f;
+
+        float dx = x2 - x1;
+        float dy = y2 - y1;
+        float len = std::sqrt(dx * dx + dy * dy);
+        if (len == 0) return;
+
+        float nx = -dy / len * w;
+        float ny = dx / len * w;
+
+        int base = pushVertex(x1 + nx, y1 + ny, c);
+        pushVertex(x1 - nx, y1 - ny, c);
+        pushVertex(x2 - nx, y2 - ny, c);
+        pushVertex(x2 + nx, y2 + ny, c);
+
+        pushTriangle(base, base + 1, base + 2);
+        pushTriangle(base, base + 2, base + 3);
+    }
+
+    void drawQuadraticBezier(Vec2 start, Vec2 control, Vec2 end, float width, Color c) {
+        int segments = 30;
+        Vec2 prev = start;
+        for (int i = 1; i <= segments; i++) {
+            float t = (float)i / segments;
+            float invT = 1.0f - t;
+            // B(t) = (1-t)^2 * P0 + 2(1-t)t * P1 + t^2 * P2
+            float x = invT * invT * start.x + 2 * invT * t * control.x + t * t * end.x;
+            float y = invT * invT * start.y + 2 * invT * t * control.y + t * t * end.y;
+            Vec2 curr = { x, y };
+            drawThickLine(prev.x, prev.y, curr.x, curr.y, width, c);
+            prev = curr;
+        }
+    }
+
+    void drawPolygon(float x, float y, Span<Vec2> points, float rotation, float scale, Color c) {
+        float cosR = std::cos(rotation);
+        float sinR = std::sin(rotation);
+
+        int center = pushVertex(x, y, c);
+        for (const auto& pt : points) {
+            float rx = pt.x * cosR - pt.y * sinR;
+            float ry = pt.x * sinR + pt.y * cosR;
+            pushVertex(x + rx * scale, y + ry * scale, c);
+        }
+
+        int n = points.size;
+        for (int i = 0; i < n; i++) {
+            pushTriangle(center, center + i + 1, (i == n - 1) ? center + 1 : center + i + 2);
+        }
+    }
+
+    void drawNumber(int number, float x, float y, float size, Color c) {
+        Span<char> s = scratch<char>(16);
+        s.size = std::snprintf(s.data, s.size, "%d", number);
+        float currX = x;
+        for (char ch : s) {
+            float w = size *0.6f;
+            float h = size;
+
+            auto line = [&](float x1, float y1, float x2, float y2) {
+                drawThickLine(currX + x1 * w, y + y1 * h, currX + x2 * w, y + y2 * h, 3, c);
+            };
+
+            if (strchr("02356789", ch)) line(0, 0, 1, 0); // Top
+            if (strchr("2345689", ch))  line(0, 0.5, 1, 0.5); // Mid
+            if (strchr("0235689", ch))  line(0, 1, 1, 1); // Bot
+            if (strchr("045689", ch))   line(0, 0, 0, 0.5); // TopLeft
+            if (strchr("01234789", ch)) line(1, 0, 1, 0.5); // TopRight
+            if (strchr("0268", ch))     line(0, 0.5, 0, 1); // BotLeft
+            if (strchr("013456789", ch))line(1, 0.5, 1, 1); // BotRight
+
+            currX += w + 10;
+        }
+    }
+
+    void drawText(std::string text, float x, float y, float size, Color c) {
+
+    }
+
+private:
+    // Consecutive primitives with the same state share one item.
+    DrawItem& currentItem() {
+        if (items.empty() || !items.back().sameState(state)) {
+            DrawItem item = state;
+            item.depth = (Uint32)items.size();
+            item.firstVertex = (int)colors.size();
+            item.vertexCount = 0;
+            item.firstIndex = (int)indices.size();
+            item.indexCount = 0;
+            items.push_back(item);
+        }
+        return items.back();
+    }
+};
+
+// Sorts the recorded items by key and submits them in as few SDL batches as possible.
+// World batches are transformed in bulk by the camera matrix at flush time; screen
+// layers are submitted untransformed. With `soft` set the items are rasterized on
+// the CPU instead and reach SDL as a single texture upload.
+class Renderer : public RenderQueue {
+public:
+    SDL_Renderer* renderer;
+    int screenW, screenH;
+    Mat2x3 view = MAT_IDENTITY;
+    std::vector<SDL_Texture*> textures;
+
+    std::vector<float> batchXY;
+    std::vector<float> batchUV;
+    std::vector<SDL_Color> batchColor;
+    std::vector<int> batchIndices;
+    DrawItem batchState = {};
+    SDL_BlendMode currentBlend = SDL_BLENDMODE_INVALID;
+    Color clearColor = COL_BG_DARK;
+
+    // Fraction of the window resolution the world layers are rasterized at.
+    // Below 1 they go to sceneTarget first and get stretched over the window;
+    // screen layers (HUD, flash, overlays) are always drawn at native size.
+    float renderScale = 1.0f;
+    SDL_Texture* sceneTarget = nullptr;
+    int sceneTargetW = 0, sceneTargetH = 0;
+    bool sceneTargetFailed = false;
+    SDL_Rect sceneRect = { 0, 0, 0, 0 };
+    Mat2x3 batchView = MAT_IDENTITY;
+    float appliedScale = 1.0f; // What the last submit actually used
+
+    // Software rasterizer backend, when selected. Draws at native size:
+    // renderScale does not apply.
+    SoftRasterizer* soft = nullptr;
+    SDL_Texture* softFrame = nullptr; // Streaming texture the framebuffer is uploaded to
+    int softFrameW = 0, softFrameH = 0;
+
+    // Per-frame submission counters
+    int drawCalls = 0;
+    int blendChanges = 0;
+
+    Renderer(SDL_Renderer* r, int w, int h) : renderer(r), screenW(w), screenH(h) {}
+
+    // `image` is the surface the texture was made from; the software backend
+    // samples its own copy of it.
+    Uint16 addTexture(SDL_Texture* texture, SDL_Surface* image = nullptr) {
+        textures.push_back(texture);
+        if (soft) soft->addTexture(image);
+        return (Uint16)textures.size();
+    }
+
+    // Starts recording a frame seen through cam, over a background cleared to bg.
+    void beginFrame(const Camera& cam, Color bg) {
+        clear();
+        clearColor = bg;
+        drawCalls = 0;
+        blendChanges = 0;
+        view = cam.viewMatrix();
+        worldRect = cam.visibleWorldRect();
+        screenRect = { 0, 0, (float)screenW, (float)screenH };
+        setLayer(LAYER_BACKGROUND);
+    }
+
+    // Maps a world point to screen pixels.
+    Vec2 transform(float x, float y) const {
+        return { view.a * x + view.b * y + view.tx, view.c * x + view.d * y + view.ty };
+    }
+
+    void setColor(Color c) {
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+    }
+
+    void submit() {
+        sortItems();
+        if (soft) {
+            submitSoft();
+            return;
+        }
+
+        // World layers sort before screen layers, so the scaled scene is
+        // finished and composited before the first native-resolution item.
+        bool scaled = beginScene();
+        for (const DrawItem& item : items) {
+            if (scaled && !isWorldLayer(item.layer)) {
+                flush();
+                endScene();
+                scaled = false;
+            }
+            if (!batchIndices.empty() && !canBatch(batchState, item)) flush();
+            if (batchIndices.empty()) batchState = item;
+
+            int base = (int)batchColor.size();
+            batchXY.insert(batchXY.end(), xy.begin() + item.firstVertex * 2, xy.begin() + (item.firstVertex + item.vertexCount) * 2);
+            batchUV.insert(batchUV.end(), uv.begin() + item.firstVertex * 2, uv.begin() + (item.firstVertex + item.vertexCount) * 2);
+            batchColor.insert(batchColor.end(), colors.begin() + item.firstVertex, colors.begin() + item.firstVertex + item.vertexCount);
+            for (int i = 0; i < item.indexCount; i++) {
+                batchIndices.push_back(indices[item.firstIndex + i] + base);
+            }
+        }
+        flush();
+        if (scaled) endScene();
+    }
+
+private:
+    // Same order as the SDL path, so blending comes out the same; only world
+    // items need their points transformed first.
+    void submitSoft() {
+        appliedScale = 1.0f;
+        Color bg = clearColor;
+        soft->begin(screenW, screenH, (Uint32)bg.r << 16 | (Uint32)bg.g << 8 | bg.b);
+        for (const DrawItem& item : items) {
+            const float* points = &xy[item.firstVertex * 2];
+            if (isWorldLayer(item.layer)) {
+                batchXY.assign(points, points + item.vertexCount * 2);
+                transformPoints(batchXY.data(), item.vertexCount, view);
+                points = batchXY.data();
+            }
+            soft->addTriangles(points, &colors[item.firstVertex], &uv[item.firstVertex * 2],
+                &indices[item.firstIndex], item.indexCount, item.blend, item.texture);
+        }
+        batchXY.clear();
+        soft->finish();
+
+        if (!softFrame || softFrameW != screenW || softFrameH != screenH) {
+            if (softFrame) SDL_DestroyTexture(softFrame);
+            softFrame = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, screenW, screenH);
+            if (softFrame) SDL_SetTextureBlendMode(softFrame, SDL_BLENDMODE_NONE);
+            softFrameW = screenW;
+            softFrameH = screenH;
+        }
+        if (!softFrame) return;
+        SDL_UpdateTexture(softFrame, NULL, soft->pixels.data(), soft->pitch());
+        SDL_RenderCopy(renderer, softFrame, NULL, NULL);
+        drawCalls = 1;
+    }
+
+    // Clears the frame and points world rendering at the right target.
+    // Returns true if world layers go to the downscaled sceneTarget.
+    bool beginScene() {
+        batchView = view;
+        bool scaled = renderScale < 1.0f && ensureSceneTarget();
+        if (scaled) {
+            sceneRect.w = std::max(1, (int)(screenW * renderScale + 0.5f));
+            sceneRect.h = std::max(1, (int)(screenH * renderScale + 0.5f));
+            SDL_SetRenderTarget(renderer, sceneTarget);
+            // Scale per axis from the rounded size so the scene fills sceneRect exactly
+            float sx = (float)sceneRect.w / screenW;
+            float sy = (float)sceneRect.h / screenH;
+            batchView = { view.a * sx, view.b * sx, view.tx * sx, view.c * sy, view.d * sy, view.ty * sy };
+        }
+        appliedScale = scaled ? renderScale : 1.0f;
+        setColor(clearColor);
+        SDL_RenderClear(renderer);
+        return scaled;
+    }
+
+    // Back to the window, stretching the scene over it.
+    void endScene() {
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_RenderCopy(renderer, sceneTarget, &sceneRect, NULL);
+        drawCalls++;
+    }
+
+    // The target is allocated at full window size so that changing the scale
+    // only changes how much of it is used.
+    bool ensureSceneTarget() {
+        if (sceneTargetFailed) return false;
+        if (sceneTarget && sceneTargetW == screenW && sceneTargetH == screenH) return true;
+
+        if (sceneTarget) SDL_DestroyTexture(sceneTarget);
+        sceneTarget = nullptr;
+        if (SDL_RenderTargetSupported(renderer)) {
+            sceneTarget = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, screenW, screenH);
+        }
+        if (!sceneTarget) {
+            std::cerr << "[render] no render target support, resolution scaling disabled: " << SDL_GetError() << std::endl;
+            sceneTargetFailed = true;
+            return false;
+        }
+        SDL_SetTextureBlendMode(sceneTarget, SDL_BLENDMODE_NONE);
+        SDL_SetTextureScaleMode(sceneTarget, SDL_ScaleModeLinear);
+        sceneTargetW = screenW;
+        sceneTargetH = screenH;
+        return true;
+    }
+
+    static bool canBatch(const DrawItem& a, const DrawItem& b) {
+        return isWorldLayer(a.layer) == isWorldLayer(b.layer) && a.blend == b.blend && a.texture == b.texture;
+    }
+
+    SDL_BlendMode blendFromIndex(int index) const {
+        if (index == 0) return SDL_BLENDMODE_NONE;
+        if (index == 2) return SDL_BLENDMODE_ADD;
+        return SDL_BLENDMODE_BLEND;
+    }
+
+    void flush() {
+        if (batchIndices.empty()) return;
+        int count = (int)batchColor.size();
+        if (isWorldLayer(batchState.layer)) transformPoints(batchXY.data(), count, batchView);
+
+        SDL_Texture* texture = batchState.texture ? textures[batchState.texture - 1] : NULL;
+        if (!texture) {
+            SDL_BlendMode mode = blendFromIndex(batchState.blend);
+            if (mode != currentBlend) {
+                SDL_SetRenderDrawBlendMode(renderer, mode);
+                currentBlend = mode;
+                blendChanges++;
+            }
+        }
+
+        SDL_RenderGeometryRaw(renderer, texture,
+            batchXY.data(), sizeof(float) * 2,
+            batchColor.data(), sizeof(SDL_Color),
+            texture ? batchUV.data() : NULL, texture ? sizeof(float) * 2 : 0,
+            count, batchIndices.data(), (int)batchIndices.size(), sizeof(int));
+        drawCalls++;
+
+        batchXY.clear();
+        batchUV.clear();
+        batchColor.clear();
+        batchIndices.clear();
+    }
+};
+
+enum EnemyType { CRATE, SPIKE, HEX };
+
+struct Enemy {
+    Uint32 id;
+    float x, y;
+    float prevX, prevY; // Position at the start of the current tick
+    float size;
+    float speed;
+    float vx;
+    float swayOffset, swaySpeed, swayAmplitude;
+    float rotation, rotSpeed;
+    EnemyType type;
+    Color color;
+    bool active;
+    bool dormant;      // Skipped by update() until caught up, see Simulation LOD
+    long steppedFrame; // Frame of the latest step applied
+};
+
+struct Particle {
+    float x, y;
+    float vx, vy;
+    float life; // 0.0 - 1.0
+    float size;
+    Color color;
+    float decay;
+    int type; // 0: Normal, 1: Lightning, 2: Debris, 3: Spark
+    float w, h; // For Debris
+    float rotation, vRot;
+};
+
+struct FloatingText {
+    float x, y;
+    int value; // Simplified to just numbers for this renderer
+    float vy;
+    float life;
+    Color color;
+};
+
+struct Explosion {
+    float x, y;
+    float life;
+    float rotation;
+    float scale;
+};
+
+struct Shockwave {
+    float x, y;
+    float radius;
+    float maxRadius;
+    float alpha;
+    float width;
+    Color color;
+};
+
+
+enum GameState { MENU, PLAYING, GAME_OVER };
+GameState gameState = MENU;
+int score = 0;
+float health = 100.0f;
+int level = 1;
+long frames = 0;
+float shakeIntensity = 0;
+float flashIntensity = 0;
+float camZoom = 1.0f;
+
+enum PunchState { IDLE, WINDUP, SMASH, HOLD, RECOVER };
+
+// What one player does in a tick: where they aim and whether they clicked.
+struct PlayerInput {
+    Sint16 x, y;
+    bool punch;
+};
+
+bool operator==(const PlayerInput& a, const PlayerInput& b) {
+    return a.x == b.x && a.y == b.y && a.punch == b.punch;
+}
+
+// Which enemy a smash aimed at a point would lock onto, where it would land,
+// and how many enemies its kill box is expected to catch.
+struct SmashPlan {
+    bool valid;
+    int target; // Index into enemies
+    Vec2 point;
+    int expectedKills;
+};
+
+struct Player {
+    float x, y;
+    float width = 40, height = 60;
+    Color color = COL_BLUE_500;
+
+    PlayerInput input = {}; // Applied at the start of the tick
+    Vec2 leftArm = { 0,0 }, rightArm = { 0,0 };
+    Vec2 leftArmPrev = { 0,0 }, rightArmPrev = { 0,0 }; // Before the latest arm update
+    PunchState punchState = IDLE;
+    int punchTimer = 0;
+    Vec2 punchTarget = { 0,0 };
+    Uint32 lockedEnemyId = 0; // 0: none
+    bool hasSmashImpacted = false;
+    int smashKills = 0; // Enemies killed by the current smash
+    SmashPlan smashPreview = { false, -1, { 0, 0 }, 0 };
+};
+
+const int MAX_PLAYERS = 2;
+Player players[MAX_PLAYERS];
+int playerCount = 1;
+
+// Local pointer state, turned into players[0].input once per tick.
+struct Mouse {
+    int x, y;
+    bool clicked; // Since the last tick
+} mouse;
+SDL_Texture* playerTexture = nullptr;
+Uint16 playerTextureId = 0;
+int hitStop = 0;
+Uint32 nextEnemyId = 1;
+
+// What happened during the latest tick, for telemetry. Cleared at the start of
+// every simulated tick, so after a rollback it holds the newest tick only.
+struct TickEvents {
+    int kills;
+    int smashes;    // Ended this tick
+    int smashKills; // Kills of the smashes that ended
+    int blocks;
+    int headHits;
+} tickEvents;
+
+std::vector<Enemy> enemies;
+std::vector<Particle> particles;
+std::vector<Shockwave> shockwaves;
+std::vector<Explosion> explosions;
+std::vector<FloatingText> floatingTexts;
+
+// A player as a game starts. The arms stay where they were until the first
+// tick puts them back at rest.
+void resetPlayer(Player& player) {
+    player.x = WINDOW_WIDTH / 2.0f;
+    player.y = WINDOW_HEIGHT - 100.0f;
+    player.punchState = IDLE;
+    player.lockedEnemyId = 0;
+}
+
+void initGame() {
+    score = 0;
+    health = 100;
+    level = 1;
+    enemies.clear();
+    particles.clear();
+    shockwaves.clear();
+    explosions.clear();
+    floatingTexts.clear();
+    for (int i = 0; i < playerCount; i++) resetPlayer(players[i]);
+    frames = 0;
+}
+
+const Enemy* findEnemy(const std::vector<Enemy>& list, Uint32 id) {
+    if (id == 0) return nullptr;
+    for (const Enemy& e : list) {
+        if (e.id == id) return &e;
+    }
+    return nullptr;
+}
+
+// Difficulty curve: how fast enemies come and fall as the score grows, and
+// the score each level starts at. Shared with the batch simulator, which is
+// how these get tuned.
+struct Balance {
+    int spawnInterval = 60;        // Ticks between spawns at score 0...
+    int spawnIntervalMin = 10;     // ...never fewer...
+    int spawnScoreStep = 100;      // ...one less per this many points
+    float speedBonusMax = 5;       // Extra fall speed, at most...
+    float speedBonusScore = 3000;  // ...one per this many points
+    int levelScore = 1000;         // Points per level, up to level 4
+};
+
+Balance balance;
+
+int spawnIntervalFor(int score) {
+    return std::max(balance.spawnIntervalMin, balance.spawnInterval - score / balance.spawnScoreStep);
+}
+
+float speedBonusFor(int score) {
+    return std::min(balance.speedBonusMax, score / balance.speedBonusScore);
+}
+
+int levelFor(int score) {
+    return std::min(4, score / balance.levelScore + 1);
+}
+
+// Size of the gloves, their reach and the kill box at a level.
+float levelScale(int level) {
+    return 1.0f + (level - 1) * 0.5f;
+}
+
+// A new enemy above the top edge, drawn from `random`. The caller gives it its
+// id and first frame.
+Enemy rollEnemy(Uint32& random, int score) {
+    float size = randomFloat(random, 30, 70);
+    int typeRoll = randomInt(random, 3);
+    EnemyType type = (EnemyType)typeRoll;
+    Color c;
+    if (type == CRATE) c = { 217, 119, 6, 255 }; // Wood
+    else if (type == SPIKE) c = { 239, 68, 68, 255 }; // Red
+    else c = { 139, 92, 246, 255 }; // Purple
+
+    Enemy e;
+    e.id = 0;
+    e.x = randomFloat(random, size, WINDOW_WIDTH - size);
+    e.y = -size;
+    e.prevX = e.x;
+    e.prevY = e.y;
+    e.size = size;
+    e.speed = randomFloat(random, 2, 4) + speedBonusFor(score);
+    e.vx = (randomFloat(random, 0, 1) - 0.5f) * 4.0f;
+    e.swayOffset = randomFloat(random, 0, PI * 2);
+    e.swaySpeed = 0.05f + randomFloat(random, 0, 0.05f);
+    e.rotation = 0;
+    e.rotSpeed = (randomFloat(random, 0, 1) - 0.5f) * 0.1f;
+    e.swayAmplitude = 7.0f;
+    e.type = type;
+    e.color = c;
+    e.active = true;
+    e.dormant = false;
+    e.steppedFrame = 0;
+    return e;
+}
+
+void spawnEnemy() {
+    Enemy e = rollEnemy(simRandom, score);
+    e.id = nextEnemyId++;
+    e.steppedFrame = frames - 1; // Takes its first step this tick
+    enemies.push_back(e);
+}
+
+void createParticles(float x, float y, Color c, int count, float scale = 1.0f) {
+    for (int i = 0; i < count; i++) {
+        Particle p = {};
+        float angle = randomFloat(0, PI * 2);
+        float speed = randomFloat(1, 4) * scale;
+        p.x = x; p.y = y;
+        p.vx = std::cos(angle) * speed;
+        p.vy = std::sin(angle) * speed;
+        p.life = 1.0f;
+        p.color = c;
+        p.size = randomFloat(2, 7);
+        p.decay = 0.03f;
+        p.type = 0; // Normal
+        particles.push_back(p);
+    }
+}
+
+void createDebris(float x, float y, Color c, int count, float scale) {
+    for (int i = 0; i < count; i++) {
+        Particle p = {};
+        float angle = randomFloat(0, PI * 2);
+        float force = randomFloat(5, 15) * scale;
+        p.x = x; p.y = y;
+        p.vx = std::cos(angle) * force;
+        p.vy = std::sin(angle) * force;
+        p.rotation = randomFloat(0, PI);
+        p.vRot = (randomFloat(0, 1) - 0.5f) * 0.8f;
+        p.life = 1.0f;
+        p.color = c;
+        p.w = randomFloat(4, 16) * scale;
+        p.h = randomFloat(4, 16) * scale;
+        p.type = 2; // Debris
+        particles.push_back(p);
+    }
+}
+
+// --- Sound ---
+
+enum Sound { SOUND_IMPACT, SOUND_KILL, SOUND_BLOCK, SOUND_HURT, SOUND_LEVEL_UP, SOUND_COUNT };
+
+AudioEngine audio;
+int soundIds[SOUND_COUNT];
+bool soundMuted = false; // Set while rolled back ticks are simulated again: they were heard already
+
+// Called from the simulation; x pans the sound across the window.
+void playSound(Sound sound, float x, float volume = 1.0f) {
+    if (soundMuted) return;
+    audio.play(soundIds[sound], volume, x / WINDOW_WIDTH * 2 - 1);
+}
+
+// Short decaying tone sweeping from f0 to f1 Hz, mixed with some noise.
+void synthTone(std::vector<float>& pcm, float seconds, float f0, float f1, float decay, float noise, Uint32 seed) {
+    int n = (int)(seconds * AudioEngine::SAMPLE_RATE);
+    size_t start = pcm.size();
+    pcm.resize(start + n);
+    float phase = 0;
+    for (int i = 0; i < n; i++) {
+        float t = (float)i / n;
+        float env = std::exp(-decay * t) * std::min(1.0f, i / 48.0f); // 1 ms attack, no click
+        seed = seed * 1664525u + 1013904223u;
+        float white = (seed >> 8) * (2.0f / 16777216.0f) - 1;
+        phase += 2 * PI * (f0 + (f1 - f0) * t) / AudioEngine::SAMPLE_RATE;
+        pcm[start + i] = env * ((1 - noise) * std::sin(phase) + noise * white);
+    }
+}
+
+// The game ships no audio assets, so its samples are synthesized once at startup.
+void loadSounds(AudioEngine& engine) {
+    std::vector<float> pcm;
+    synthTone(pcm, 0.35f, 140, 40, 8, 0.3f, 1);
+    soundIds[SOUND_IMPACT] = engine.addSample(pcm);
+
+    pcm.clear();
+    synthTone(pcm, 0.12f, 700, 180, 10, 0.35f, 2);
+    soundIds[SOUND_KILL] = engine.addSample(pcm);
+
+    pcm.clear();
+    std::vector<float> overtone;
+    synthTone(pcm, 0.15f, 820, 800, 12, 0.1f, 3);
+    synthTone(overtone, 0.15f, 1270, 1240, 16, 0, 4);
+    for (size_t i = 0; i < pcm.size(); i++) pcm[i] = 0.6f * pcm[i] + 0.4f * overtone[i];
+    soundIds[SOUND_BLOCK] = engine.addSample(pcm);
+
+    pcm.clear();
+    synthTone(pcm, 0.3f, 95, 70, 5, 0.5f, 5);
+    soundIds[SOUND_HURT] = engine.addSample(pcm);
+
+    pcm.clear();
+    synthTone(pcm, 0.1f, 523, 523, 3, 0, 6);
+    synthTone(pcm, 0.1f, 659, 659, 3, 0, 7);
+    synthTone(pcm, 0.25f, 784, 784, 5, 0, 8);
+    soundIds[SOUND_LEVEL_UP] = engine.addSample(pcm);
+}
+
+// --- Simulation LOD ---
+
+// Enemies that can neither be seen nor reach a head, a glove or a kill box go
+// dormant: update() skips them, and they are caught up every SIM_LOD_INTERVAL
+// ticks, or right away once they might matter or a punch or the bot's target
+// choice reads the enemy list. Catching up replays the skipped ticks with the
+// same arithmetic as a full-rate step, so a dormant enemy is bit for bit where
+// it would have been and no gameplay outcome can differ. Enemies only ever move
+// down, by `speed` a tick, which bounds where a dormant one can be.
+bool simLod = true; // --no-sim-lod turns it off, for comparison
+const int SIM_LOD_INTERVAL = 8;
+
+// How far from its center anything recordEnemies() draws for e can reach: the
+// spikes and outline stay within size + 15, and the shadow is offset by
+// (10, 10), less than 15 away. The renderer culls with it and updateSimLod()
+// keeps enemies within it of the view awake.
+float enemyDrawRadius(const Enemy& e) {
+    return e.size + 15 + 15;
+}
+
+void stepEnemy(Enemy& e, long frame) {
+    e.prevX = e.x;
+    e.prevY = e.y;
+    e.y += e.speed;
+    float currentWind = std::sin(frame * e.swaySpeed + e.swayOffset) * e.swayAmplitude;
+    e.x += e.vx + currentWind;
+
+    if (e.x < e.size / 2) {
+        e.x = e.size / 2;
+        e.vx *= -1;
+    }
+    if (e.x > WINDOW_WIDTH - e.size / 2) {
+        e.x = WINDOW_WIDTH - e.size / 2;
+        e.vx *= -1;
+    }
+
+    e.rotation += e.rotSpeed;
+    e.steppedFrame = frame;
+}
+
+void catchUp(Enemy& e) {
+    while (e.steppedFrame < frames) stepEnemy(e, e.steppedFrame + 1);
+}
+
+// Brings every enemy up to date, for code that reads their positions.
+void wakeEnemies() {
+    for (Enemy& e : enemies) {
+        if (!e.dormant) continue;
+        catchUp(e);
+        e.dormant = false;
+    }
+}
+
+// Smallest y at which anything can touch an enemy during the next tick: a
+// head, a glove, or the kill box of a smash winding up or under way. Sized for
+// the top level, in case the next tick levels up. A punch started next tick
+// wakes everything in triggerPunch and only hits after its windup.
+float gameplayTop() {
+    const float maxScale = 2.5f;
+    float top = (float)WINDOW_HEIGHT;
+    for (int i = 0; i < playerCount; i++) {
+        const Player& p = players[i];
+        top = std::min(top, p.y - p.height - p.width / 2);
+        float gloveY = std::min(std::min(p.leftArm.y, p.rightArm.y), std::min(p.leftArmPrev.y, p.rightArmPrev.y));
+        top = std::min(top, gloveY - 30 * maxScale);
+        if (p.punchState == WINDUP || p.punchState == SMASH) top = std::min(top, p.punchTarget.y - 80 * maxScale);
+    }
+    return top;
+}
+
+// Decides at the end of a tick which enemies update() may skip next tick.
+void updateSimLod() {
+    if (!simLod) return;
+    float top = gameplayTop() - 1; // 1 px for rounding in the bounds below
+    // Camera zoom only ever magnifies, so the view reaches up to half the shake above the window
+    float viewTop = -shakeIntensity / 2 - 1;
+    for (Enemy& e : enemies) {
+        // Lowest it can be by the end of the next tick
+        long lag = frames - e.steppedFrame;
+        float y = e.y + e.speed * (lag + 1);
+        bool locked = false;
+        for (int i = 0; i < playerCount; i++) locked = locked || players[i].lockedEnemyId == e.id;
+
+        if (y + e.size / 2 >= top || y + enemyDrawRadius(e) >= viewTop || locked) {
+            catchUp(e);
+            e.dormant = false;
+        }
+        else {
+            if (lag >= SIM_LOD_INTERVAL) catchUp(e);
+            e.dormant = true;
+        }
+    }
+}
+
+// --- Smash Prediction ---
+
+// Steps e forward `ticks` ticks from `frame` exactly the way update() moves it,
+// wall bounces included.
+Vec2 predictEnemyStepped(const Enemy& e, long frame, int ticks) {
+    float simX = e.x;
+    float simY = e.y;
+    float simVx = e.vx;
+
+    for (int i = 1; i <= ticks; i++) {
+        long simFrame = frame + i;
+
+        simY += e.speed;
+
+        float simWind = std::sin(simFrame * e.swaySpeed + e.swayOffset) * e.swayAmplitude;
+
+        simX += simVx + simWind;
+
+        float margin = e.size / 2.0f;
+        if (simX < margin) {
+            simX = margin;
+            simVx *= -1;
+        }
+        else if (simX > WINDOW_WIDTH - margin) {
+            simX = WINDOW_WIDTH - margin;
+            simVx *= -1;
+        }
+    }
+    return { simX, simY };
+}
+
+// 2 pi split in two for range reduction: the first part has few enough bits
+// that turns * TWO_PI_HI is exact.
+const float TWO_PI_HI = 6.28125f;
+const float TWO_PI_LO = 1.9353071795864769e-3f;
+
+// Sine within 4e-6 of std::sin for the arguments the sway sees in any game:
+// reduced to about [-pi, pi], folded onto [-pi/2, pi/2] (a bit past pi comes
+// out as a small negative angle), then a degree 9 polynomial. sin4() does the
+// same arithmetic four lanes at a time, so SSE2 and scalar builds get the same
+// bits.
+inline float fastSin(float x) {
+    float turns = std::nearbyint(x * (1 / (2 * PI)));
+    x = x - turns * TWO_PI_HI;
+    x = x - turns * TWO_PI_LO;
+    float a = std::abs(x);
+    a = std::min(a, PI - a);
+    float a2 = a * a;
+    float p = 1 / 362880.0f;
+    p = p * a2 + -1 / 5040.0f;
+    p = p * a2 + 1 / 120.0f;
+    p = p * a2 + -1 / 6.0f;
+    p = p * a2 + 1.0f;
+    return std::signbit(x) ? -(p * a) : p * a;
+}
+
+#ifdef SMASH_SSE2
+inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// fastSin() of four floats.
+inline __m128 sin4(__m128 x) {
+    __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1 / (2 * PI)))));
+    x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(TWO_PI_HI)));
+    x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(TWO_PI_LO)));
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 sign = _mm_and_ps(x, signMask);
+    __m128 a = _mm_andnot_ps(signMask, x);
+    a = _mm_min_ps(a, _mm_sub_ps(_mm_set1_ps(PI), a));
+    __m128 a2 = _mm_mul_ps(a, a);
+    __m128 p = _mm_set1_ps(1 / 362880.0f);
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-1 / 5040.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(1 / 120.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-1 / 6.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(1.0f));
+    return _mm_xor_ps(_mm_mul_ps(p, a), sign);
+}
+#endif
+
+// Predicts e `ticks` ticks ahead of `frame` in closed form instead of tick by tick.
+//
+// Over ticks frame+1 .. frame+n the sway adds
+//     A * sum sin(w*i + p) = A * sin(w*(frame + (n+1)/2) + p) * sin(w*n/2) / sin(w/2)
+// and walls are handled by folding. update() flips vx at a wall but not the
+// sway, so only the drift e.x + vx * n is folded back into
+// [size/2, width - size/2], then the sway is added and the result clamped.
+// Enemies that stay clear of the walls come out exact up to rounding; those
+// that bounce within the horizon are typically within a pixel, off by more
+// only when the sway pins them against a wall for several ticks.
+// predictEnemyStepped() is exact for those. The sines are fastSin(), so this
+// matches TrajectoryPredictor's SSE2 pass bit for bit.
+Vec2 predictEnemy(const Enemy& e, long frame, int ticks, float width) {
+    float f = (float)frame;
+    float n = (float)ticks;
+    float w = e.swaySpeed;
+    float half = fastSin(w * 0.5f);
+    float sway = std::abs(half) > 1e-6f
+        ? fastSin(w * (f + (n + 1) * 0.5f) + e.swayOffset) * fastSin(w * n * 0.5f) / half
+        : n * fastSin(w * f + e.swayOffset);
+    float px = e.x + e.vx * n;
+
+    float margin = e.size * 0.5f;
+    float span = width - 2 * margin;
+    if (span > 0) {
+        float period = 2 * span;
+        float v = px - margin;
+        float u = v - std::floor(v / period) * period;
+        px = margin + (u <= span ? u : period - u);
+    }
+    px = px + e.swayAmplitude * sway;
+    return { std::min(width - margin, std::max(margin, px)), e.y + e.speed * n };
+}
+
+// Predicts every enemy at once: the enemies are gathered into SoA form and
+// predictEnemy() runs on four of them at a time, as does the kill box test.
+// Each enemy is predicted from the latest step applied to it, so dormant ones
+// need no catching up: the horizon simply grows by their lag.
+class TrajectoryPredictor {
+public:
+    std::vector<float> x, y;
+
+    void predict(const std::vector<Enemy>& list, long frame, int ticks, float width) {
+        int count = (int)list.size();
+        x.resize(count);
+        y.resize(count);
+        for (Lane* in : { &startX, &startY, &vx, &speed, &size, &swaySpeed, &swayOffset, &swayAmplitude, &startFrame, &horizon }) in->resize(count);
+        for (int i = 0; i < count; i++) {
+            const Enemy& e = list[i];
+            startFrame[i] = (float)e.steppedFrame;
+            horizon[i] = (float)(ticks + (frame - e.steppedFrame));
+            startX[i] = e.x;
+            startY[i] = e.y;
+            vx[i] = e.vx;
+            speed[i] = e.speed;
+            size[i] = e.size;
+            swaySpeed[i] = e.swaySpeed;
+            swayOffset[i] = e.swayOffset;
+            swayAmplitude[i] = e.swayAmplitude;
+        }
+
+        int i = 0;
+#ifdef SMASH_SSE2
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 vwidth = _mm_set1_ps(width);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        for (; i + 4 <= count; i += 4) {
+            __m128 f = _mm_loadu_ps(&startFrame[i]);
+            __m128 n = _mm_loadu_ps(&horizon[i]);
+            __m128 w = _mm_loadu_ps(&swaySpeed[i]);
+            __m128 offset = _mm_loadu_ps(&swayOffset[i]);
+            __m128 sinHalf = sin4(_mm_mul_ps(w, half));
+            __m128 summed = _mm_div_ps(_mm_mul_ps(
+                sin4(_mm_add_ps(_mm_mul_ps(w, _mm_add_ps(f, _mm_mul_ps(_mm_add_ps(n, _mm_set1_ps(1.0f)), half))), offset)),
+                sin4(_mm_mul_ps(_mm_mul_ps(w, n), half))), sinHalf);
+            __m128 flat = _mm_mul_ps(n, sin4(_mm_add_ps(_mm_mul_ps(w, f), offset)));
+            __m128 sway = select4(_mm_cmpgt_ps(_mm_and_ps(sinHalf, absMask), _mm_set1_ps(1e-6f)), summed, flat);
+            __m128 px = _mm_add_ps(_mm_loadu_ps(&startX[i]), _mm_mul_ps(_mm_loadu_ps(&vx[i]), n));
+
+            // Fold the drift back between the walls
+            __m128 margin = _mm_mul_ps(_mm_loadu_ps(&size[i]), half);
+            __m128 span = _mm_sub_ps(vwidth, _mm_mul_ps(two, margin));
+            __m128 period = _mm_mul_ps(two, span);
+            __m128 v = _mm_sub_ps(px, margin);
+            __m128 q = _mm_div_ps(v, period);
+            __m128 turns = _mm_cvtepi32_ps(_mm_cvttps_epi32(q));
+            turns = _mm_sub_ps(turns, _mm_and_ps(_mm_cmpgt_ps(turns, q), _mm_set1_ps(1.0f))); // floor
+            __m128 u = _mm_sub_ps(v, _mm_mul_ps(turns, period));
+            __m128 folded = _mm_add_ps(margin, select4(_mm_cmple_ps(u, span), u, _mm_sub_ps(period, u)));
+            px = select4(_mm_cmpgt_ps(span, _mm_setzero_ps()), folded, px);
+
+            px = _mm_add_ps(px, _mm_mul_ps(_mm_loadu_ps(&swayAmplitude[i]), sway));
+            px = _mm_min_ps(_mm_max_ps(px, margin), _mm_sub_ps(vwidth, margin));
+            _mm_storeu_ps(&x[i], px);
+            _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&startY[i]), _mm_mul_ps(_mm_loadu_ps(&speed[i]), n)));
+        }
+#endif
+        for (; i < count; i++) {
+            const Enemy& e = list[i];
+            Vec2 p = predictEnemy(e, e.steppedFrame, ticks + (int)(frame - e.steppedFrame), width);
+            x[i] = p.x;
+            y[i] = p.y;
+        }
+
+        for (int j = 0; j < count; j++) {
+            if (list[j].active) continue;
+            // Far enough away to never land in a kill box
+            x[j] = -1e9f;
+            y[j] = -1e9f;
+        }
+    }
+
+    // Number of predicted positions strictly inside the box, same test as checkCollision.
+    int countInBox(float cx, float cy, float hw, float hh) const {
+        int count = (int)x.size();
+        int hits = 0;
+        int i = 0;
+#ifdef SMASH_SSE2
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+        const __m128 vhw = _mm_set1_ps(hw), vhh = _mm_set1_ps(hh);
+        for (; i + 4 <= count; i += 4) {
+            __m128 dx = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&x[i]), vcx), absMask);
+            __m128 dy = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&y[i]), vcy), absMask);
+            int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(dx, vhw), _mm_cmplt_ps(dy, vhh)));
+            hits += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        }
+#endif
+        for (; i < count; i++) {
+            if (std::abs(x[i] - cx) < hw && std::abs(y[i] - cy) < hh) hits++;
+        }
+        return hits;
+    }
+
+private:
+    typedef std::vector<float> Lane;
+    Lane startX, startY, vx, speed, size, swaySpeed, swayOffset, swayAmplitude;
+    Lane startFrame, horizon;
+};
+
+TrajectoryPredictor predictor;
+bool targetPreview = false;
+
+// Among the enemies within `size + reach` of aim, picks the lock that kills the
+// most, nearest to aim on ties. One vectorised prediction pass, then a box
+// count over every enemy for each candidate in reach, four enemies at a time.
+// Dormant enemies in `list` are measured from where they last stepped:
+// callers whose choice changes the game wake them first. The batch simulator
+// plans for its worlds with their own list, frame, level and predictor.
+SmashPlan planSmash(const std::vector<Enemy>& list, long frame, int level, TrajectoryPredictor& prediction, Vec2 aim, float reach) {
+    SmashPlan plan = { false, -1, { 0, 0 }, 0 };
+    int ticks = WINDUP_FRAMES + calculateFlightFrames(SMASH_SPEED);
+    prediction.predict(list, frame, ticks, (float)WINDOW_WIDTH);
+
+    float scale = levelScale(level);
+    float closestDist = 9999.0f;
+    for (int i = 0; i < (int)list.size(); i++) {
+        const Enemy& e = list[i];
+        if (!e.active) continue;
+        float d = dist(aim, { e.x, e.y });
+        if (d >= e.size + reach) continue;
+
+        int kills = prediction.countInBox(prediction.x[i], prediction.y[i], 44 * scale, 80 * scale);
+        if (kills > plan.expectedKills || (kills == plan.expectedKills && d < closestDist)) {
+            closestDist = d;
+            plan.valid = true;
+            plan.target = i;
+            plan.point = { prediction.x[i], prediction.y[i] };
+            plan.expectedKills = kills;
+        }
+    }
+    return plan;
+}
+
+SmashPlan planSmash(Vec2 aim, float reach = 100) {
+    return planSmash(enemies, frames, level, predictor, aim, reach);
+}
+
+// Starts a punch from the player's input, locked on by planSmash() among
+// `list`, which must be up to date.
+void startPunch(Player& player, const std::vector<Enemy>& list, long frame, int level, TrajectoryPredictor& prediction) {
+    player.punchState = WINDUP;
+    player.punchTimer = 0;
+    player.hasSmashImpacted = false;
+    player.smashKills = 0;
+    player.lockedEnemyId = 0;
+
+    SmashPlan plan = planSmash(list, frame, level, prediction, { (float)player.input.x, (float)player.input.y }, 100);
+    if (plan.valid) {
+        const Enemy& target = list[plan.target];
+        player.lockedEnemyId = target.id;
+        // The closed form only chose the target; aim with the exact path
+        player.punchTarget = predictEnemyStepped(target, frame, WINDUP_FRAMES + calculateFlightFrames(SMASH_SPEED));
+    }
+    else {
+        player.punchTarget.x = (float)player.input.x;
+        player.punchTarget.y = (float)player.input.y;
+    }
+}
+
+void triggerPunch(Player& player) {
+    wakeEnemies();
+    startPunch(player, enemies, frames, level, predictor);
+}
+
+void triggerImpact(float x, float y, float scale) {
+    playSound(SOUND_IMPACT, x, std::min(1.0f, 0.5f + level * 0.125f));
+
+    // Level specific effects
+    if (level == 1) {
+        shakeIntensity = 10;
+    }
+    else if (level == 2) {
+        shockwaves.push_back({ x, y, 20, 15, 1.0f, 30, COL_ORANGE });
+        createParticles(x, y, COL_ORANGE, 20);
+        shakeIntensity = 25;
+    }
+    else if (level >= 3) {
+        shockwaves.push_back({ x, y, 30, 25, 1.0f, 10, COL_YELLOW_400 });
+        // Sparks
+        for (int i = 0; i < 10; i++) {
+            Particle p = {};
+            float angle = randomFloat(0, PI * 2);
+            float spd = randomFloat(10, 25);
+            p.x = x; p.y = y;
+            p.vx = std::cos(angle) * spd; p.vy = std::sin(angle) * spd;
+            p.life = 1.0f; p.type = 3; p.color = COL_WHITE;
+            p.w = 3 * scale; // width
+            particles.push_back(p);
+        }
+        shakeIntensity = 40;
+        camZoom = 1.4f;
+        if (level == 4) {
+            flashIntensity = 0.8f;
+            camZoom = 1.6f;
+            shockwaves.push_back({ x, y, 10, 40, 1.0f, 20, COL_PURPLE });
+        }
+    }
+}
+
+// Gameplay rules shared by update() and the batch simulator's worlds.
+const float HEAD_HIT_DAMAGE = 20;
+const int BLOCK_POINTS = 10;
+const int SMASH_HIT_STOP = 4; // Ticks the world freezes after a kill, from level 2 on
+
+// Where the player stands this tick: under their pointer, kept on screen.
+void placePlayer(Player& player) {
+    player.y = WINDOW_HEIGHT - 100.0f;
+    player.x = (float)player.input.x;
+    if (player.x < 20) player.x = 20;
+    if (player.x > WINDOW_WIDTH - 20) player.x = WINDOW_WIDTH - 20;
+}
+
+// True if an enemy of `size` moving from `from` to `to` this tick hits the
+// player's head. The head jumps to the pointer and is only ever drawn there,
+// so the enemy is swept against where the head ends up.
+bool hitsHead(const Player& player, Vec2 from, Vec2 to, float size) {
+    Vec2 head = { player.x, player.y - player.height };
+    return sweptCircleHit(from, to, head, head, size / 2 + player.width / 2);
+}
+
+// True if the player's idle gloves block such an enemy. The gloves moved at
+// the end of the previous tick, the enemy during this one.
+bool blocksEnemy(const Player& player, int level, Vec2 from, Vec2 to, float size) {
+    if (player.punchState != IDLE) return false;
+    float gloveRadius = 30.0f * levelScale(level);
+    bool hitLeft = sweptCircleHit(from, to, player.leftArmPrev, player.leftArm, size / 2 + gloveRadius);
+    bool hitRight = sweptCircleHit(from, to, player.rightArmPrev, player.rightArm, size / 2 + gloveRadius);
+    return hitLeft || hitRight;
+}
+
+// The kill box between the gloves during one tick of a smash, swept from
+// where its centre was at the start of the tick.
+struct SmashBox {
+    float centerX, prevCenterX, y;
+    float gloveGap; // Between the gloves' centres
+    float scale;
+};
+
+bool inSmashBox(const SmashBox& box, Vec2 from, Vec2 to) {
+    float killWidth = 44 * box.scale;
+    // AABB Collision, swept along both the enemy's and the box's motion
+    return sweptBoxHit(from, to, { box.prevCenterX, box.y }, { box.centerX, box.y }, killWidth, 80 * box.scale);
+}
+
+int smashPoints(const SmashBox& box, float size) {
+    return (int)(size * box.scale * 2);
+}
+
+// Kills every enemy that passed through the kill box this tick.
+void checkCollision(Player& player, const SmashBox& box) {
+    float gloveReach = 44 * box.scale;
+
+    if (box.gloveGap <= gloveReach * 2 ) {
+        if (!player.hasSmashImpacted) {
+            triggerImpact(box.centerX, box.y, box.scale);
+            player.hasSmashImpacted = true;
+        }
+    }
+
+    int hitCount = 0;
+    for (auto& e : enemies) {
+        if (!e.active) continue;
+        if (inSmashBox(box, { e.prevX, e.prevY }, { e.x, e.y })) {
+
+            e.active = false;
+            int pts = smashPoints(box, e.size);
+            score += pts;
+            hitCount++;
+
+            createDebris(e.x, e.y, e.color, 8 + level * 4, box.scale);
+            floatingTexts.push_back({ e.x, e.y, pts, -2.0f, 1.0f, COL_YELLOW_400 });
+
+            if (level >= 2) hitStop = SMASH_HIT_STOP;
+        }
+    }
+
+    player.smashKills += hitCount;
+    tickEvents.kills += hitCount;
+    if (hitCount > 0) {
+        shakeIntensity += 5 * hitCount;
+        playSound(SOUND_KILL, box.centerX, std::min(1.0f, 0.4f + 0.2f * hitCount));
+    }
+}
+
+// What one tick of moveArms() leaves for the world to resolve.
+struct ArmsTick {
+    bool smashing;   // The gloves are closing in and `box` is live
+    bool smashEnded; // The smash turned into the hold
+    SmashBox box;
+};
+
+// Moves one player's arms through the punch cycle at `frame`.
+ArmsTick moveArms(Player& player, long frame, int level) {
+    ArmsTick tick = {};
+    Vec2 shoulderL = { player.x - 20, player.y - 40 };
+    Vec2 shoulderR = { player.x + 20, player.y - 40 };
+    player.leftArmPrev = player.leftArm;
+    player.rightArmPrev = player.rightArm;
+
+    if (player.punchState == IDLE) {
+        float floatY = std::sin(frame * 0.1f) * 5.0f;
+        player.leftArm = { shoulderL.x - 40, shoulderL.y + 20 + floatY };
+        player.rightArm = { shoulderR.x + 40, shoulderR.y + 20 + floatY };
+    }
+    else if (player.punchState == WINDUP) {
+        player.punchTimer++;
+        float tx = player.punchTarget.x;
+        float ty = player.punchTarget.y;
+
+        player.leftArm.x += (tx - 250 - player.leftArm.x) * 0.25f;
+        player.leftArm.y += (ty - player.leftArm.y) * 0.25f;
+        player.rightArm.x += (tx + 250 - player.rightArm.x) * 0.25f;
+        player.rightArm.y += (ty - player.rightArm.y) * 0.25f;
+
+        if (player.punchTimer > WINDUP_FRAMES) { player.punchState = SMASH; player.punchTimer = 0; }
+    }
+    else if (player.punchState == SMASH) {
+        player.punchTimer++;
+        float scale = levelScale(level);
+        float reach = 36 * scale;
+        float speed = SMASH_SPEED;
+
+        float txL = player.punchTarget.x - reach;
+        float txR = player.punchTarget.x + reach;
+
+        player.leftArm.x += (txL - player.leftArm.x) * speed;
+        player.leftArm.y += (player.punchTarget.y - player.leftArm.y) * speed;
+        player.rightArm.x += (txR - player.rightArm.x) * speed;
+        player.rightArm.y += (player.punchTarget.y - player.rightArm.y) * speed;
+
+        if (player.leftArm.x > player.punchTarget.x - reach) player.leftArm.x = player.punchTarget.x - reach;
+        if (player.rightArm.x < player.punchTarget.x + reach) player.rightArm.x = player.punchTarget.x + reach;
+
+        if (std::abs(player.rightArm.x - player.leftArm.x) <= reach * 2 + 15) {
+            tick.smashing = true;
+            tick.box.centerX = (player.leftArm.x + player.rightArm.x) / 2;
+            tick.box.prevCenterX = (player.leftArmPrev.x + player.rightArmPrev.x) / 2;
+            tick.box.y = player.punchTarget.y;
+            tick.box.gloveGap = std::abs(player.rightArm.x - player.leftArm.x);
+            tick.box.scale = scale;
+        }
+
+        if (player.punchTimer > 5) {
+            player.punchState = HOLD;
+            player.punchTimer = 0;
+            tick.smashEnded = true;
+        }
+
+    }
+    else if (player.punchState == HOLD) {
+        player.punchTimer++;
+        if (player.punchTimer > 6) { player.punchState = RECOVER; player.punchTimer = 0; }
+    }
+    else if (player.punchState == RECOVER) {
+        player.punchTimer++;
+        float floatY = std::sin(frame * 0.1f) * 5.0f;
+
+        float targetXL = shoulderL.x - 40;
+        float targetYL = shoulderL.y + 20 + floatY;
+        float targetXR = shoulderR.x + 40;
+        float targetYR = shoulderR.y + 20 + floatY;
+
+        player.leftArm.x += (targetXL - player.leftArm.x) * 0.2f;
+        player.leftArm.y += (targetYL - player.leftArm.y) * 0.2f;
+        player.rightArm.x += (targetXR - player.rightArm.x) * 0.2f;
+        player.rightArm.y += (targetYR - player.rightArm.y) * 0.2f;
+
+        if (player.punchTimer > 10) {
+            player.punchState = IDLE;
+            player.leftArm = { targetXL, targetYL };
+            player.rightArm = { targetXR, targetYR };
+        }
+    }
+    return tick;
+}
+
+// moveArms() for the current tick, with what the smash sets off.
+void updateArms(Player& player) {
+    ArmsTick tick = moveArms(player, frames, level);
+    if (tick.smashing) checkCollision(player, tick.box);
+    if (tick.smashEnded) {
+        tickEvents.smashes++;
+        tickEvents.smashKills += player.smashKills;
+    }
+}
+
+void update() {
+    if (gameState != PLAYING) return;
+    if (hitStop > 0) { hitStop--; return; }
+
+    frames++;
+
+    if (shakeIntensity > 0) shakeIntensity *= 0.85f;
+    if (shakeIntensity < 0.5f) shakeIntensity = 0;
+    if (flashIntensity > 0) flashIntensity -= 0.1f;
+    if (camZoom > 1.0f) camZoom -= 0.05f;
+    if (camZoom < 1.0f) camZoom = 1.0f;
+
+    int newLevel = levelFor(score);
+    if (newLevel > level) {
+        level = newLevel;
+        shakeIntensity = 30;
+        flashIntensity = 0.5f;
+        playSound(SOUND_LEVEL_UP, WINDOW_WIDTH / 2.0f);
+    }
+
+    for (int i = 0; i < playerCount; i++) placePlayer(players[i]);
+
+    if (frames % spawnIntervalFor(score) == 0) spawnEnemy();
+
+    for (auto& e : enemies) {
+        if (!e.active) continue;
+
+        if (e.dormant) continue;
+        stepEnemy(e, frames);
+
+        Vec2 from = { e.prevX, e.prevY };
+        Vec2 to = { e.x, e.y };
+        for (int i = 0; i < playerCount && e.active; i++) {
+            if (hitsHead(players[i], from, to, e.size)) {
+                e.active = false;
+                health -= HEAD_HIT_DAMAGE;
+                createDebris(e.x, e.y, e.color, 10, 1.0f);
+                shakeIntensity = 15;
+                flashIntensity = 0.4f;
+                playSound(SOUND_HURT, e.x);
+                tickEvents.headHits++;
+                if (health <= 0) gameState = GAME_OVER;
+            }
+        }
+
+        bool blocked = false;
+        for (int i = 0; i < playerCount && !blocked; i++) blocked = blocksEnemy(players[i], level, from, to, e.size);
+        if (blocked) {
+            e.active = false;
+            createParticles(e.x, e.y, { 220, 220, 220, 255 }, 10, 1.2f);
+            shakeIntensity = 5;
+            playSound(SOUND_BLOCK, e.x, 0.7f);
+            tickEvents.blocks++;
+            score += BLOCK_POINTS;
+            continue;
+        }
+        if (e.y > WINDOW_HEIGHT + e.size / 2) e.active = false;
+    }
+
+    enemies.erase(std::remove_if(enemies.begin(), enemies.end(), [](const Enemy& e) { return !e.active; }), enemies.end());
+
+    for (auto& p : particles) {
+        if (p.type == 2) {
+            p.x += p.vx; p.y += p.vy;
+            p.rotation += p.vRot;
+            p.vy += 0.4f;
+            p.life -= 0.015f;
+            if (p.y > WINDOW_HEIGHT || p.y < 0 || p.x > WINDOW_WIDTH || p.x < 0) { p.life = 0; }
+        }
+        else if (p.type == 3) { // Spark
+            p.x += p.vx; p.y += p.vy;
+            p.life -= 0.05f;
+        }
+        else {
+            p.x += p.vx; p.y += p.vy;
+            p.life -= p.decay;
+        }
+    }
+    particles.erase(std::remove_if(particles.begin(), particles.end(), [](const Particle& p) { return p.life <= 0; }), particles.end());
+
+    // Update Shockwaves
+    for (auto& s : shockwaves) {
+        s.radius += s.maxRadius; // actually using maxRadius as speed storage here
+        s.width *= 0.8f;
+        s.alpha -= 0.05f;
+    }
+    shockwaves.erase(std::remove_if(shockwaves.begin(), shockwaves.end(), [](const Shockwave& s) { return s.alpha <= 0; }), shockwaves.end());
+
+    // Update Texts
+    for (auto& t : floatingTexts) {
+        t.y += t.vy;
+        t.vy *= 0.9f;
+        t.life -= 0.02f;
+    }
+    floatingTexts.erase(std::remove_if(floatingTexts.begin(), floatingTexts.end(), [](const FloatingText& t) { return t.life <= 0; }), floatingTexts.end());
+
+    for (int i = 0; i < playerCount; i++) {
+        Player& player = players[i];
+        updateArms(player);
+
+        player.smashPreview.valid = false;
+        if (targetPreview && player.punchState == IDLE) player.smashPreview = planSmash({ (float)player.input.x, (float)player.input.y });
+    }
+
+    updateSimLod();
+}
+
+// Advances the world by one tick with one input per player. Clicks start a new
+// game from the menu and game over screens and punches while playing.
+void simulateTick(const PlayerInput* inputs) {
+    tickEvents = {};
+    bool clicked = false;
+    for (int i = 0; i < playerCount; i++) {
+        players[i].input = inputs[i];
+        clicked = clicked || inputs[i].punch;
+    }
+
+    if (gameState == MENU || gameState == GAME_OVER) {
+        if (!clicked) return;
+        initGame();
+        gameState = PLAYING;
+    }
+    else {
+        for (int i = 0; i < playerCount; i++) {
+            if (inputs[i].punch && players[i].punchState == IDLE) triggerPunch(players[i]);
+        }
+    }
+    update();
+}
+
+// --- World State ---
+
+// Everything the simulation reads and writes, copied out of and back into the
+// globals. Entities are plain structs, so capture and restore come down to a
+// few memcpys, and a slot that is reused keeps its vectors' capacity and stops
+// allocating once it has seen the largest world.
+struct WorldState {
+    GameState gameState;
+    int score;
+    float health;
+    int level;
+    long frames;
+    float shakeIntensity, flashIntensity, camZoom;
+    int hitStop;
+    Uint32 random;
+    Uint32 nextEnemyId;
+    int playerCount;
+    Player players[MAX_PLAYERS];
+    std::vector<Enemy> enemies;
+    std::vector<Particle> particles;
+    std::vector<Shockwave> shockwaves;
+    std::vector<Explosion> explosions;
+    std::vector<FloatingText> floatingTexts;
+
+    void capture() {
+        gameState = ::gameState;
+        score = ::score;
+        health = ::health;
+        level = ::level;
+        frames = ::frames;
+        shakeIntensity = ::shakeIntensity;
+        flashIntensity = ::flashIntensity;
+        camZoom = ::camZoom;
+        hitStop = ::hitStop;
+        random = simRandom;
+        nextEnemyId = ::nextEnemyId;
+        playerCount = ::playerCount;
+        std::copy(::players, ::players + MAX_PLAYERS, players);
+        enemies = ::enemies;
+        particles = ::particles;
+        shockwaves = ::shockwaves;
+        explosions = ::explosions;
+        floatingTexts = ::floatingTexts;
+    }
+
+    void restore() const {
+        ::gameState = gameState;
+        ::score = score;
+        ::health = health;
+        ::level = level;
+        ::frames = frames;
+        ::shakeIntensity = shakeIntensity;
+        ::flashIntensity = flashIntensity;
+        ::camZoom = camZoom;
+        ::hitStop = hitStop;
+        simRandom = random;
+        ::nextEnemyId = nextEnemyId;
+        ::playerCount = playerCount;
+        std::copy(players, players + MAX_PLAYERS, ::players);
+        ::enemies = enemies;
+        ::particles = particles;
+        ::shockwaves = shockwaves;
+        ::explosions = explosions;
+        ::floatingTexts = floatingTexts;
+    }
+};
+
+static_assert(std::is_trivially_copyable<Player>::value, "WorldState copies players as plain data");
+static_assert(std::is_trivially_copyable<Enemy>::value && std::is_trivially_copyable<Particle>::value, "WorldState copies entities as plain data");
+
+// --- Rollback ---
+
+// Stands in for the network link to a remote player: every input pushed comes
+// out `delay` ticks later, in order.
+class DelayedInputQueue {
+public:
+    static const int CAPACITY = 64;
+    int delay = 0;
+
+    void push(long tick, PlayerInput input) {
+        if (count == CAPACITY) return; // Link saturated: the packet is lost
+        packets[(head + count) % CAPACITY] = { tick, tick + delay, input };
+        count++;
+    }
+
+    // Next input that has arrived by `now`, if any.
+    bool pop(long now, long& tick, PlayerInput& input) {
+        if (count == 0 || packets[head].arrival > now) return false;
+        tick = packets[head].tick;
+        input = packets[head].input;
+        head = (head + 1) % CAPACITY;
+        count--;
+        return true;
+    }
+
+private:
+    struct Packet {
+        long tick;
+        long arrival;
+        PlayerInput input;
+    };
+    Packet packets[CAPACITY];
+    int head = 0;
+    int count = 0;
+};
+
+// Keeps the simulation running ahead of a remote player's input. Each tick is
+// simulated with the remote input predicted from the last one received
+// (same aim, no click). When the real input for an earlier tick arrives and
+// differs, the world is restored to the start of that tick and re-simulated
+// up to the present with the corrected inputs.
+class RollbackSession {
+public:
+    static const int MAX_ROLLBACK = 15; // Ticks
+    int localPlayer = 0;
+    int remotePlayer = 1;
+    long tick = 0; // Next tick to simulate
+
+    // Counters since the last resetStats()
+    long rollbacks = 0;
+    long resimulatedTicks = 0;
+    long lateInputs = 0; // Too old to roll back to
+    double saveMs = 0, restoreMs = 0;
+    long saves = 0, restores = 0;
+
+    RollbackSession() {
+        for (int i = 0; i < HISTORY; i++) remoteTicks[i] = -1;
+    }
+
+    // The remote player's real input for tick t.
+    void receive(long t, PlayerInput input) {
+        if (t < tick - MAX_ROLLBACK) {
+            lateInputs++;
+            return;
+        }
+        int slot = (int)(t % HISTORY);
+        remoteInputs[slot] = input;
+        remoteTicks[slot] = t;
+        if (t > lastRemoteTick) {
+            lastRemoteTick = t;
+            lastRemote = input;
+        }
+        if (t < tick && !(usedRemote[slot] == input)) {
+            rollbackFrom = rollbackFrom < 0 ? t : std::min(rollbackFrom, t);
+        }
+    }
+
+    // Simulates the next tick with the local player's input.
+    void advance(PlayerInput local) {
+        if (rollbackFrom >= 0) {
+            restore(rollbackFrom);
+            soundMuted = true;
+            for (long t = rollbackFrom; t < tick; t++) {
+                if (t > rollbackFrom) save(t);
+                step(t);
+                resimulatedTicks++;
+            }
+            soundMuted = false;
+            rollbacks++;
+            rollbackFrom = -1;
+        }
+
+        localInputs[tick % HISTORY] = local;
+        save(tick);
+        step(tick);
+        tick++;
+    }
+
+    void resetStats() {
+        rollbacks = resimulatedTicks = lateInputs = saves = restores = 0;
+        saveMs = restoreMs = 0;
+    }
+
+private:
+    static const int HISTORY = MAX_ROLLBACK + 1;
+    WorldState states[HISTORY]; // World at the start of each tick
+    PlayerInput localInputs[HISTORY];
+    PlayerInput usedRemote[HISTORY]; // What each tick was simulated with
+    PlayerInput remoteInputs[HISTORY];
+    long remoteTicks[HISTORY]; // Tick each remoteInputs entry belongs to
+    PlayerInput lastRemote = {};
+    long lastRemoteTick = -1;
+    long rollbackFrom = -1;
+
+    PlayerInput remoteInput(long t) const {
+        int slot = (int)(t % HISTORY);
+        if (remoteTicks[slot] == t) return remoteInputs[slot];
+        PlayerInput predicted = lastRemote;
+        predicted.punch = false;
+        return predicted;
+    }
+
+    void step(long t) {
+        int slot = (int)(t % HISTORY);
+        PlayerInput inputs[MAX_PLAYERS] = {};
+        inputs[localPlayer] = localInputs[slot];
+        inputs[remotePlayer] = usedRemote[slot] = remoteInput(t);
+        simulateTick(inputs);
+    }
+
+    void save(long t) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        states[t % HISTORY].capture();
+        saveMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        saves++;
+    }
+
+    void restore(long t) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        states[t % HISTORY].restore();
+        restoreMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        restores++;
+    }
+};
+
+// Read-only view of the world for one frame. Record jobs only read from it,
+// so they can run on worker threads while the simulation is not stepping.
+struct RenderSnapshot {
+    GameState gameState;
+    int level;
+    long frames;
+    int score;
+    float health;
+    float flashIntensity;
+    int playerCount;
+    Player players[MAX_PLAYERS];
+    const std::vector<Enemy>* enemies;
+    const std::vector<Particle>* particles;
+    const std::vector<Shockwave>* shockwaves;
+    const std::vector<FloatingText>* floatingTexts;
+    Uint16 playerTextureId;
+};
+
+RenderSnapshot takeRenderSnapshot() {
+    RenderSnapshot s;
+    s.gameState = gameState;
+    s.level = level;
+    s.frames = frames;
+    s.score = score;
+    s.health = health;
+    s.flashIntensity = flashIntensity;
+    s.playerCount = playerCount;
+    std::copy(players, players + MAX_PLAYERS, s.players);
+    s.enemies = &enemies;
+    s.particles = &particles;
+    s.shockwaves = &shockwaves;
+    s.floatingTexts = &floatingTexts;
+    s.playerTextureId = playerTextureId;
+    return s;
+}
+
+void drawGlove(RenderQueue& q, const RenderSnapshot& world, float x, float y, bool isLeft, Color cuff) {
+    int level = world.level;
+    float s = 1.0f + (level - 1) * 0.3f;
+
+    q.setLayer(LAYER_GLOVE_AURA, SDL_BLENDMODE_ADD);
+    Color auraColor = COL_RED_500;
+    if (level == 2) auraColor = COL_ORANGE;
+    if (level == 3) auraColor = COL_YELLOW_400;
+    if (level == 4) auraColor = COL_PURPLE;
+
+    if (level >= 2) {
+        float pulse = std::sin(world.frames * 0.2f) * 5.0f;
+        auraColor.a = 60;
+        q.fillCircle(x, y, (40 + pulse) * s, auraColor);
+    }
+    q.setLayer(LAYER_GLOVES);
+
+    Color gc = COL_RED_500;
+    if (level == 2) gc = COL_ORANGE;
+    if (level == 3) gc = COL_YELLOW_400;
+    if (level == 4) gc = COL_PURPLE;
+
+    float cuffOffsetX = isLeft ? -20 * s : 20 * s;
+
+    q.drawThickLine(
+        x + cuffOffsetX, y - 15 * s,
+        x + cuffOffsetX, y + 15 * s, 
+        12 * s,
+        cuff
+    );
+
+    float gloveOffsetX = isLeft ? 5 * s : -5 * s;
+    q.fillCircle(x + gloveOffsetX, y, 28 * s, gc);
+
+    float thumbX = isLeft ? 15 * s : -15 * s;
+    q.fillCircle(x + thumbX, y - 10 * s, 12 * s, gc);
+
+    q.fillCircle(x + gloveOffsetX, y - 10 * s, 8 * s, { 255, 255, 255, 80 });
+}
+
+// --- Record jobs ---
+// Each one records a slice [begin, end) of some entity list into its own queue.
+// Jobs are appended to the frame in the order they are listed in FrameRecorder::record(),
+// which is also the order the serial path runs them in.
+
+void recordBackground(RenderQueue& q, const RenderSnapshot& world, int /*begin*/, int /*end*/) {
+    q.setLayer(LAYER_BACKGROUND, SDL_BLENDMODE_NONE);
+    const ViewRect& visible = q.worldRect;
+    float floorY = world.players[0].y;
+    q.fillRect(visible.minX, floorY, visible.maxX, visible.maxY, { 20, 25, 40, 255 });
+    q.drawThickLine(0, floorY, WINDOW_WIDTH, floorY, 4, { 60, 70, 90, 255 });
+
+    //Additive Layer
+    q.setLayer(LAYER_EFFECTS, SDL_BLENDMODE_ADD);
+
+    for (auto& s : *world.shockwaves) {
+        if (!q.isVisible(s.x, s.y, s.radius)) continue;
+        Color c = s.color;
+        c.a = (Uint8)(s.alpha * 255);
+        q.fillCircle(s.x, s.y, s.radius, c);
+    }
+}
+
+void recordParticles(RenderQueue& q, const RenderSnapshot& world, int begin, int end) {
+    q.setLayer(LAYER_EFFECTS, SDL_BLENDMODE_ADD);
+
+    for (int i = begin; i < end; i++) {
+        const Particle& p = (*world.particles)[i];
+        Color c = p.color;
+        if (p.type == 3) { // Spark (Line)
+            float trail = 2.0f * (std::abs(p.vx) + std::abs(p.vy));
+            if (!q.isVisible(p.x, p.y, trail + p.w)) continue;
+            c.a = (Uint8)(p.life * 255);
+            q.drawThickLine(p.x, p.y, p.x - p.vx * 2, p.y - p.vy * 2, p.w, c);
+        }
+        else if (p.type != 2) { // Not Debris
+            if (!q.isVisible(p.x, p.y, p.size)) continue;
+            c.a = (Uint8)(p.life * 255);
+            q.fillCircle(p.x, p.y, p.size, c);
+        }
+    }
+}
+
+void recordDebris(RenderQueue& q, const RenderSnapshot& world, int begin, int end) {
+    q.setLayer(LAYER_DEBRIS);
+
+    for (int i = begin; i < end; i++) {
+        const Particle& p = (*world.particles)[i];
+        if (p.type == 2) {
+            if (!q.isVisible(p.x, p.y, (p.w + p.h) / 2)) continue;
+            Span<Vec2> shape = q.scratch<Vec2>(4);
+            shape[0] = { -p.w / 2, -p.h / 2 };
+            shape[1] = { p.w / 2, -p.h / 4 };
+            shape[2] = { 0, p.h / 2 };
+            shape[3] = { -p.w / 2, p.h / 4 };
+            q.drawPolygon(p.x, p.y, shape, p.rotation, 1.0f, p.color);
+        }
+    }
+}
+
+void recordEnemies(RenderQueue& q, const RenderSnapshot& world, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        const Enemy& e = (*world.enemies)[i];
+        if (!q.isVisible(e.x, e.y, enemyDrawRadius(e))) continue;
+
+        auto getRotatedPos = [&](float dx, float dy) -> Vec2 {
+            float rx = dx * std::cos(e.rotation) - dy * std::sin(e.rotation);
+            float ry = dx * std::sin(e.rotation) + dy * std::cos(e.rotation);
+            return { e.x + rx, e.y + ry };
+        };
+
+        if (e.type == CRATE) {
+            float hs = e.size / 2.0f;
+            Span<Vec2> boxShape = q.scratch<Vec2>(4);
+            boxShape[0] = { -hs, -hs };
+            boxShape[1] = { hs, -hs };
+            boxShape[2] = { hs, hs };
+            boxShape[3] = { -hs, hs };
+
+            Color shadowCol = { 0, 0, 0, 80 };
+            q.setLayer(LAYER_SHADOWS);
+            q.drawPolygon(e.x + 10, e.y + 10, boxShape, e.rotation, 1.0f, shadowCol);
+
+            q.setLayer(LAYER_BODIES);
+            q.drawPolygon(e.x, e.y, boxShape, e.rotation, 1.0f, e.color);
+
+            q.setLayer(LAYER_OUTLINES);
+            Color strokeColor = { 120, 53, 15, 255 };
+            float thick = 3.0f;
+
+            Vec2 p1 = getRotatedPos(-hs, -hs);
+            Vec2 p2 = getRotatedPos(hs, -hs);
+            Vec2 p3 = getRotatedPos(hs, hs);
+            Vec2 p4 = getRotatedPos(-hs, hs);
+
+            q.drawThickLine(p1.x, p1.y, p2.x, p2.y, thick, strokeColor);
+            q.drawThickLine(p2.x, p2.y, p3.x, p3.y, thick, strokeColor);
+            q.drawThickLine(p3.x, p3.y, p4.x, p4.y, thick, strokeColor);
+            q.drawThickLine(p4.x, p4.y, p1.x, p1.y, thick, strokeColor);
+            q.drawThickLine(p1.x, p1.y, p3.x, p3.y, thick, strokeColor);
+            q.drawThickLine(p2.x, p2.y, p4.x, p4.y, thick, strokeColor);
+        }
+        else if (e.type == HEX) {
+            Span<Vec2> hex = q.scratch<Vec2>(6);
+            for (int i = 0; i < 6; i++) {
+                float a = i * PI / 3.0f;
+                hex[i] = { std::cos(a) * e.size / 1.5f, std::sin(a) * e.size / 1.5f };
+            }
+
+            q.setLayer(LAYER_SHADOWS);
+            q.drawPolygon(e.x + 10, e.y + 10, hex, e.rotation, 1.0f, { 0, 0, 0, 80 });
+
+            q.setLayer(LAYER_BODIES);
+            q.drawPolygon(e.x, e.y, hex, e.rotation, 1.0f, e.color);
+
+            q.setLayer(LAYER_OUTLINES);
+            Color strokeColor = { 76, 29, 149, 255 }; // #4c1d95
+            for (int i = 0; i < 6; i++) {
+                float a1 = i * PI / 3.0f;
+                float a2 = (i + 1) * PI / 3.0f;
+                Vec2 p1 = getRotatedPos(std::cos(a1) * e.size / 1.5f, std::sin(a1) * e.size / 1.5f);
+                Vec2 p2 = getRotatedPos(std::cos(a2) * e.size / 1.5f, std::sin(a2) * e.size / 1.5f);
+                q.drawThickLine(p1.x, p1.y, p2.x, p2.y, 3.0f, strokeColor);
+            }
+        }
+        else {
+            int numSpikes = 8;
+            Span<Vec2> spikes = q.scratch<Vec2>(numSpikes * 2);
+            float innerR = e.size / 2.0f;
+            float outerR = e.size / 1.3f;
+
+            for (int i = 0; i < numSpikes * 2; i++) {
+                float angle = i * PI / numSpikes;
+                float r_val = (i % 2 == 0) ? outerR : innerR;
+                spikes[i] = {
+                    std::cos(angle) * r_val,
+                    std::sin(angle) * r_val
+                };
+            }
+
+            q.setLayer(LAYER_SHADOWS);
+            q.drawPolygon(e.x + 10, e.y + 10, spikes, e.rotation, 1.0f, { 0, 0, 0, 80 });
+
+            q.setLayer(LAYER_BODIES);
+            q.drawPolygon(e.x, e.y, spikes, e.rotation, 1.0f, e.color);
+
+            q.setLayer(LAYER_OUTLINES);
+            Color strokeColor = { 127, 29, 29, 255 };
+
+            for (int i = 0; i < spikes.size; i++) {
+                int next = (i + 1) % spikes.size;
+                Vec2 p1 = getRotatedPos(spikes[i].x, spikes[i].y);
+                Vec2 p2 = getRotatedPos(spikes[next].x, spikes[next].y);
+                q.drawThickLine(p1.x, p1.y, p2.x, p2.y, 2.0f, strokeColor);
+            }
+        }
+    }
+}
+
+// Lock-on reticle, kill box preview, body and gloves of one player.
+void drawPlayer(RenderQueue& q, const RenderSnapshot& world, int index) {
+    const Player& player = world.players[index];
+    const Enemy* lockedEnemy = findEnemy(*world.enemies, player.lockedEnemyId);
+    Vec2 leftArm = player.leftArm;
+    Vec2 rightArm = player.rightArm;
+
+    if (lockedEnemy && lockedEnemy->active) {
+        float size = lockedEnemy->size + 20;
+
+        q.setLayer(LAYER_RETICLE);
+
+        float cx = lockedEnemy->x;
+        float cy = lockedEnemy->y;
+        float s = size / 2.0f;
+
+        q.drawThickLine(cx - s, cy - s, cx + s, cy - s, 4, { 0, 255, 0, 255 });
+        q.drawThickLine(cx + s, cy - s, cx + s, cy + s, 4, { 0, 255, 0, 255 });
+        q.drawThickLine(cx + s, cy + s, cx - s, cy + s, 4, { 0, 255, 0, 255 });
+        q.drawThickLine(cx - s, cy + s, cx - s, cy - s, 4, { 0, 255, 0, 255 });
+    }
+
+    // Where a smash would land right now, with the kill box and its expected kills
+    const SmashPlan& preview = player.smashPreview;
+    if (preview.valid && world.gameState == PLAYING) {
+        q.setLayer(LAYER_RETICLE);
+
+        float scale = levelScale(world.level);
+        float x0 = preview.point.x - 44 * scale, x1 = preview.point.x + 44 * scale;
+        float y0 = preview.point.y - 80 * scale, y1 = preview.point.y + 80 * scale;
+        Color c = { 250, 204, 21, 160 };
+
+        q.drawThickLine(x0, y0, x1, y0, 2, c);
+        q.drawThickLine(x1, y0, x1, y1, 2, c);
+        q.drawThickLine(x1, y1, x0, y1, 2, c);
+        q.drawThickLine(x0, y1, x0, y0, 2, c);
+        q.drawNumber(preview.expectedKills, x1 + 6, y0, 20, c);
+    }
+
+    // Player
+    q.setLayer(LAYER_PLAYER);
+    Vec2 shoulderL = { player.x - 15, player.y - 50 };
+    Vec2 shoulderR = { player.x + 15, player.y - 50 };
+
+    // Arms (Bezier)
+    Vec2 midL = { (shoulderL.x + leftArm.x) / 2 - 50, (shoulderL.y + leftArm.y) / 2 + 20 };
+    q.drawQuadraticBezier(shoulderL, midL, leftArm, 24, COL_SKIN);
+
+    Vec2 midR = { (shoulderR.x + rightArm.x) / 2 + 50, (shoulderR.y + rightArm.y) / 2 + 20 };
+    q.drawQuadraticBezier(shoulderR, midR, rightArm, 24, COL_SKIN);
+
+    if (world.playerTextureId) {
+        float drawW = 1000;
+        float drawH = 1000;
+        float manualOffsetY = 450;
+        float left = player.x - drawW / 2;
+        float top = player.y - drawH + manualOffsetY;
+        q.drawTexturedRect(world.playerTextureId, left, top, left + drawW, top + drawH);
+    }
+    else {
+        q.fillCircle(player.x, player.y - 60, 30, player.color);
+    }
+
+    // Cuffs tell the players apart
+    Color cuff = index == 0 ? COL_WHITE : player.color;
+    drawGlove(q, world, leftArm.x, leftArm.y, true, cuff);
+    drawGlove(q, world, rightArm.x, rightArm.y, false, cuff);
+}
+
+// Players and the HUD.
+void recordPlayer(RenderQueue& q, const RenderSnapshot& world, int /*begin*/, int /*end*/) {
+    for (int i = 0; i < world.playerCount; i++) drawPlayer(q, world, i);
+
+    q.setLayer(LAYER_HUD);
+    q.drawNumber(world.score, 20, 50, 25, COL_YELLOW_400);
+    q.drawNumber((int)std::max(0.0f, world.health), WINDOW_WIDTH - 150, 50, 25, COL_RED_500);
+
+    // Floating Text
+    for (auto& t : *world.floatingTexts) {
+        int digits = 1;
+        for (int v = std::abs(t.value); v >= 10; v /= 10) digits++;
+        float textW = digits * (20 * 0.6f + 10);
+        if (!q.isVisible(t.x + textW / 2, t.y + 10, (textW + 20) / 2 + 3)) continue;
+
+        Color c = t.color;
+        c.a = (Uint8)(t.life * 255); // Alpha fade not fully supported by drawNumber logic but works for blending
+        q.drawNumber(t.value, t.x, t.y, 20, c);
+    }
+
+    // Flash
+    if (world.flashIntensity > 0) {
+        q.setLayer(LAYER_FLASH);
+        q.fillRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, { 255, 255, 255, (Uint8)(world.flashIntensity * 255) });
+    }
+}
+
+typedef void (*RecordFn)(RenderQueue& q, const RenderSnapshot& world, int begin, int end);
+
+struct RecordJob {
+    RecordFn fn;
+    int begin, end;
+    const RenderSnapshot* world;
+    RenderQueue queue;
+};
+
+void runRecordJob(void* ctx) {
+    RecordJob* job = (RecordJob*)ctx;
+    job->fn(job->queue, *job->world, job->begin, job->end);
+}
+
+// Splits the frame's geometry generation into record jobs with private queues,
+// runs them on the worker pool and appends the queues to the renderer in job order.
+// Because the order is fixed, the result does not depend on the thread count.
+class FrameRecorder {
+public:
+    WorkerPool pool;
+    bool verify = false;
+    long verifyMismatches = 0;
+
+    void record(Renderer& r, const RenderSnapshot& world) {
+        jobCount = 0;
+        int lanes = pool.workerCount() + 1;
+        int particleCount = (int)world.particles->size();
+        int enemyCount = (int)world.enemies->size();
+
+        addJob(recordBackground, 0, 0);
+        addChunks(recordParticles, particleCount, lanes, 256);
+        addChunks(recordDebris, particleCount, lanes, 256);
+        if (world.gameState != MENU) {
+            addChunks(recordEnemies, enemyCount, lanes, 32);
+            addJob(recordPlayer, 0, 0);
+        }
+
+        for (int i = 0; i < jobCount; i++) {
+            RecordJob& job = jobs[i];
+            job.world = &world;
+            job.queue.beginRecording(r);
+            dispatch[i] = { runRecordJob, &job };
+        }
+        pool.run(dispatch.data(), jobCount);
+
+        for (int i = 0; i < jobCount; i++) {
+            r.append(jobs[i].queue);
+        }
+
+        if (verify) verifyAgainstSerial(r, world);
+    }
+
+private:
+    std::vector<RecordJob> jobs;
+    std::vector<Job> dispatch;
+    int jobCount = 0;
+    RenderQueue reference;
+
+    void addJob(RecordFn fn, int begin, int end) {
+        if (jobCount == (int)jobs.size()) {
+            jobs.emplace_back();
+            dispatch.emplace_back();
+        }
+        RecordJob& job = jobs[jobCount++];
+        job.fn = fn;
+        job.begin = begin;
+        job.end = end;
+    }
+
+    void addChunks(RecordFn fn, int count, int lanes, int minChunk) {
+        int chunks = std::max(1, std::min(lanes, count / minChunk));
+        for (int c = 0; c < chunks; c++) {
+            addJob(fn, count * c / chunks, count * (c + 1) / chunks);
+        }
+    }
+
+    // Records the same frame on this thread into a single queue and checks that the
+    // submitted stream would be byte-identical.
+    void verifyAgainstSerial(Renderer& r, const RenderSnapshot& world) {
+        reference.beginRecording(r);
+        recordBackground(reference, world, 0, 0);
+        recordParticles(reference, world, 0, (int)world.particles->size());
+        recordDebris(reference, world, 0, (int)world.particles->size());
+        if (world.gameState != MENU) {
+            recordEnemies(reference, world, 0, (int)world.enemies->size());
+            recordPlayer(reference, world, 0, 0);
+        }
+
+        if (reference.streamDigest() != r.streamDigest()) {
+            verifyMismatches++;
+            std::cerr << "[render] parallel recording differs from serial path (frame " << world.frames << ")" << std::endl;
+        }
+    }
+};
+
+// Records the frame into the render queue; the caller submits it.
+void render(Renderer& r, FrameRecorder& recorder) {
+    // Background
+    Color bg = COL_BG_DARK;
+    if (level == 2) bg = { 46, 16, 5, 255 };
+    if (level == 3) bg = { 30, 32, 16, 255 };
+    if (level == 4) bg = { 21, 5, 46, 255 };
+
+    // Apply Camera
+    Camera cam;
+    cam.zoom = camZoom;
+    cam.screenW = r.screenW;
+    cam.screenH = r.screenH;
+    if (shakeIntensity > 0) {
+        // rand(), not the simulation RNG: shake is only visual
+        cam.shakeX = (std::rand() / (float)RAND_MAX - 0.5f) * shakeIntensity;
+        cam.shakeY = (std::rand() / (float)RAND_MAX - 0.5f) * shakeIntensity;
+    }
+    r.beginFrame(cam, bg);
+
+    RenderSnapshot world = takeRenderSnapshot();
+    recorder.record(r, world);
+}
+
+// --- Resolution Scaling ---
+
+// Picks Renderer::renderScale from recent frame times. Presentation is
+// vsynced, so a frame that fits the budget simply measures one refresh
+// period: the scale drops as soon as frames run long, and only creeps back up
+// by probing one step after a stretch of on-time frames. A probe that misses
+// immediately doubles the wait before the next one.
+struct ResolutionScaler {
+    bool enabled = true;
+    float scale = 1.0f;
+    float minScale = 0.5f;
+    float step = 0.125f;
+    double budgetMs = 1000.0 / 60.0;
+    int window = 30;
+    int frameCount = 0;
+    double totalMs = 0;
+    int onTimeWindows = 0;
+    int probeDelay = 4;
+    bool probing = false;
+
+    void addFrame(double ms) {
+        if (!enabled) return;
+        frameCount++;
+        totalMs += ms;
+        if (frameCount < window) return;
+
+        double avg = totalMs / frameCount;
+        frameCount = 0;
+        totalMs = 0;
+
+        if (avg > budgetMs * 1.2) {
+            if (probing) probeDelay = std::min(probeDelay * 2, 64);
+            scale = std::max(minScale, scale - step);
+            onTimeWindows = 0;
+        }
+        else if (avg < budgetMs * 1.05 && scale < 1.0f && ++onTimeWindows >= probeDelay) {
+            scale = std::min(1.0f, scale + step);
+            onTimeWindows = 0;
+            probing = true;
+            return;
+        }
+        else if (probing) {
+            // The probe held up
+            probeDelay = 4;
+        }
+        probing = false;
+    }
+};
+
+// --- Frame Capture ---
+
+// Reads the frame just rendered into a capture buffer, before it is presented.
+// Only the read-back happens here; encoding is on the capture's own thread.
+void captureFrame(FrameCapture& capture, SDL_Renderer* renderer, long number) {
+    FrameCapture::Frame* frame = capture.acquire();
+    if (!frame) return;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    int w, h;
+    SDL_GetRendererOutputSize(renderer, &w, &h);
+    // Buffers keep the size capture started with; a bigger window is cropped
+    SDL_Rect rect = { 0, 0, std::min(w, capture.width), std::min(h, capture.height) };
+    if (SDL_RenderReadPixels(renderer, &rect, SDL_PIXELFORMAT_RGBA32, frame->pixels.get(), capture.pitch) == 0) {
+        capture.submit(rect.w, rect.h, number);
+    }
+    capture.readMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// --- Telemetry ---
+
+// Turns the world and the events of the latest tick into telemetry records.
+struct TelemetrySampler {
+    TelemetryWriter writer;
+    unsigned tick = 0;
+    int lastScore = 0;
+
+    void sample(double tickMs, double frameMs) {
+        if (!writer.active()) return;
+        TelemetryRecord r;
+        r.tick = tick++;
+        r.frame = (unsigned)frames;
+        r.score = score;
+        r.scoreDelta = score - lastScore;
+        r.level = level;
+        r.health = health;
+        r.kills = tickEvents.kills;
+        r.smashes = tickEvents.smashes;
+        r.smashKills = tickEvents.smashKills;
+        r.blocks = tickEvents.blocks;
+        r.headHits = tickEvents.headHits;
+        r.enemies = (int)enemies.size();
+        r.particles = (int)particles.size();
+        r.tickMs = (float)tickMs;
+        r.frameMs = (float)frameMs;
+        writer.record(r);
+        lastScore = score;
+    }
+};
+
+// --- Profiler ---
+
+// Prints a summary line every `interval` frames when enabled with --stats.
+struct Profiler {
+    bool enabled = false;
+    int interval = 60;
+    int frameCount = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+    long drawn = 0;
+    long culled = 0;
+    long drawCalls = 0;
+    long blendChanges = 0;
+    long maxRenderAllocs = 0;
+    RollbackSession* rollback = nullptr; // Reported when running one
+    FrameCapture* capture = nullptr;     // Reported when capturing
+    long capturedBefore = 0, droppedBefore = 0;
+    AudioEngine* audio = nullptr;        // Reported when sound is on
+    long callbacksBefore = 0, soundsBefore = 0, stolenBefore = 0, commandsDroppedBefore = 0;
+    Uint64 callbackTicksBefore = 0, latencyTicksBefore = 0;
+
+    // renderAllocs: heap allocations made while recording and submitting the frame,
+    // -1 if allocations are not counted in this build.
+    void addFrame(double ms, const Renderer& r, long renderAllocs) {
+        if (!enabled) return;
+        frameCount++;
+        totalMs += ms;
+        maxMs = std::max(maxMs, ms);
+        drawn += r.drawnCount;
+        culled += r.culledCount;
+        drawCalls += r.drawCalls;
+        blendChanges += r.blendChanges;
+        maxRenderAllocs = std::max(maxRenderAllocs, renderAllocs);
+
+        if (frameCount >= interval) {
+            std::cout << "[profile] frame " << totalMs / frameCount << " ms avg, " << maxMs << " ms max"
+                << " | drawn " << drawn / frameCount << ", culled " << culled / frameCount
+                << " | draw calls " << drawCalls / frameCount << ", blend changes " << blendChanges / frameCount
+                << " | scale " << r.appliedScale;
+            if (renderAllocs >= 0) std::cout << " | render allocs " << maxRenderAllocs << " max/frame";
+            if (r.soft) std::cout << " | soft " << r.soft->triangleCount << " triangles, " << r.soft->binnedCount << " binned";
+            if (rollback) {
+                RollbackSession& rb = *rollback;
+                std::cout << " | rollbacks " << rb.rollbacks << ", resimulated " << rb.resimulatedTicks << " ticks"
+                    << ", snapshot " << (rb.saves ? rb.saveMs * 1000 / rb.saves : 0) << " us"
+                    << ", restore " << (rb.restores ? rb.restoreMs * 1000 / rb.restores : 0) << " us";
+                if (rb.lateInputs) std::cout << ", " << rb.lateInputs << " inputs too late";
+                rb.resetStats();
+            }
+            if (capture) {
+                FrameCapture& c = *capture;
+                std::cout << " | captured " << c.captured - capturedBefore << ", dropped " << c.dropped - droppedBefore
+                    << ", " << c.pending() << " queued";
+                capturedBefore = c.captured;
+                droppedBefore = c.dropped;
+            }
+            if (audio) printAudio(*audio);
+            std::cout << std::endl;
+            frameCount = 0;
+            totalMs = 0;
+            maxMs = 0;
+            drawn = 0;
+            culled = 0;
+            drawCalls = 0;
+            blendChanges = 0;
+            maxRenderAllocs = 0;
+        }
+    }
+
+    // Callback time against the buffer length it has to fit in, and how long
+    // play commands waited for the callback to pick them up.
+    void printAudio(AudioEngine& a) {
+        double tickMs = 1000.0 / SDL_GetPerformanceFrequency();
+        long callbacks = a.callbacks, sounds = a.started, stolen = a.stolenVoices, dropped = a.droppedCommands;
+        Uint64 callbackTicks = a.callbackTicks, latencyTicks = a.latencyTicks;
+        long n = callbacks - callbacksBefore;
+        long played = sounds - soundsBefore;
+        std::cout << " | audio callback " << (n ? (callbackTicks - callbackTicksBefore) * tickMs * 1000 / n : 0) << " us avg, "
+            << a.maxCallbackTicks.exchange(0) * tickMs * 1000 << " us max of " << a.bufferMs() << " ms"
+            << " | sounds " << played << ", latency " << (played ? (latencyTicks - latencyTicksBefore) * tickMs / played : 0) << " ms avg, "
+            << a.maxLatencyTicks.exchange(0) * tickMs << " ms max";
+        if (stolen > stolenBefore) std::cout << ", " << stolen - stolenBefore << " voices stolen";
+        if (dropped > commandsDroppedBefore) std::cout << ", " << dropped - commandsDroppedBefore << " dropped";
+        callbacksBefore = callbacks;
+        soundsBefore = sounds;
+        stolenBefore = stolen;
+        commandsDroppedBefore = dropped;
+        callbackTicksBefore = callbackTicks;
+        latencyTicksBefore = latencyTicks;
+    }
+};
+
+// --- Bot ---
+
+enum BotDifficulty { BOT_EASY, BOT_NORMAL, BOT_HARD };
+
+// Plays one player from the world state the way a person with a mouse would:
+// moves the cursor towards a target at a limited speed, waits out a reaction
+// time once the target is in lock-on range, then clicks and leaves the aiming
+// to triggerPunch's lock-on. It has its own RNG so that it never disturbs the
+// simulation's.
+struct Bot {
+    int player = 0;
+    float aimSpeed = 25;    // Pixels per tick
+    float aimJitter = 15;   // Largest aim error, in pixels
+    int reactionTicks = 8;  // In lock-on range before clicking
+    bool planKills = false; // Choose targets by expected kills instead of threat
+
+    Uint32 random = 0x2545F491u;
+    float aimX = 0, aimY = 0;
+    Vec2 aimError = { 0, 0 };
+    Uint32 targetId = 0;
+    int inRangeTicks = 0;
+    int waitTicks = 0;
+
+    void setDifficulty(BotDifficulty difficulty) {
+        if (difficulty == BOT_EASY) { aimSpeed = 12; aimJitter = 40; reactionTicks = 20; planKills = false; }
+        if (difficulty == BOT_NORMAL) { aimSpeed = 25; aimJitter = 15; reactionTicks = 8; planKills = false; }
+        if (difficulty == BOT_HARD) { aimSpeed = 60; aimJitter = 0; reactionTicks = 2; planKills = true; }
+    }
+
+    float nextRandom() {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return (random >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Input for the next tick.
+    PlayerInput think() {
+        bool click = false;
+
+        if (gameState != PLAYING) {
+            // Look at the game over screen for a moment, then start again
+            if (++waitTicks > 60) {
+                waitTicks = 0;
+                click = true;
+            }
+            return { (Sint16)aimX, (Sint16)aimY, click };
+        }
+
+        const Enemy* target = findEnemy(enemies, targetId);
+        if (!target) {
+            if (planKills) wakeEnemies();
+            target = chooseTarget(enemies, frames, level, predictor);
+            retarget(target);
+        }
+        click = steer(target, players[player].punchState == IDLE);
+        return { (Sint16)aimX, (Sint16)aimY, click };
+    }
+
+    // The batch simulator drives the parts below for its own worlds.
+
+    void retarget(const Enemy* target) {
+        targetId = target ? target->id : 0;
+        inRangeTicks = 0;
+        aimError = { (nextRandom() * 2 - 1) * aimJitter, (nextRandom() * 2 - 1) * aimJitter };
+    }
+
+    // Moves the aim one tick towards the target, or the middle of the screen
+    // without one, and returns true to click.
+    bool steer(const Enemy* target, bool idle) {
+        float goalX = target ? target->x + aimError.x : WINDOW_WIDTH / 2.0f;
+        float goalY = target ? target->y + aimError.y : WINDOW_HEIGHT / 2.0f;
+        float dx = goalX - aimX, dy = goalY - aimY;
+        float len = std::sqrt(dx * dx + dy * dy);
+        if (len > aimSpeed) {
+            dx *= aimSpeed / len;
+            dy *= aimSpeed / len;
+        }
+        aimX = std::min((float)WINDOW_WIDTH, std::max(0.0f, aimX + dx));
+        aimY = std::min((float)WINDOW_HEIGHT, std::max(0.0f, aimY + dy));
+
+        // Same range triggerPunch locks onto
+        if (target && dist({ aimX, aimY }, { target->x, target->y }) < target->size + 100) {
+            if (++inRangeTicks >= reactionTicks && idle) {
+                targetId = 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Picks among `list`, which must be up to date for planKills.
+    const Enemy* chooseTarget(const std::vector<Enemy>& list, long frame, int level, TrajectoryPredictor& prediction) {
+        if (planKills) {
+            SmashPlan plan = planSmash(list, frame, level, prediction, { aimX, aimY }, 1e6f);
+            return plan.valid ? &list[plan.target] : nullptr;
+        }
+        // The on-screen enemy closest to the ground
+        const Enemy* lowest = nullptr;
+        for (const Enemy& e : list) {
+            if (e.active && e.y > 0 && (!lowest || e.y > lowest->y)) lowest = &e;
+        }
+        return lowest;
+    }
+};
+
+// --- Soak Log ---
+
+// Health report for long runs, every `interval` ticks: resident memory, entity
+// counts, heap allocations and tick time percentiles over the interval.
+struct SoakLog {
+    bool enabled = false;
+    int interval = 600;
+    long ticks = 0;
+    long games = 0;
+    int bestScore = 0;
+    long lastAllocs = -1;
+    std::vector<double> tickMs;
+
+    void addTick(double ms) {
+        if (!enabled) return;
+        if (tickMs.capacity() < (size_t)interval) tickMs.reserve(interval);
+        tickMs.push_back(ms);
+        ticks++;
+        bestScore = std::max(bestScore, score);
+        if (frames == 1) games++;
+
+        if ((int)tickMs.size() < interval) return;
+
+        long rss = residentSetKB();
+        long allocs = allocationCount();
+        std::sort(tickMs.begin(), tickMs.end());
+        int n = (int)tickMs.size();
+
+        std::cout << "[soak] tick " << ticks << " | game " << games << ", level " << level << ", score " << score << " (best " << bestScore << ")";
+        if (rss >= 0) std::cout << " | rss " << rss / 1024.0 << " MB";
+        std::cout << " | enemies " << enemies.size() << ", particles " << particles.size() << " (capacity " << particles.capacity() << ")"
+            << ", shockwaves " << shockwaves.size() << ", texts " << floatingTexts.size();
+        if (allocs >= 0) {
+            std::cout << " | allocs " << allocs;
+            if (lastAllocs >= 0) std::cout << " (+" << (double)(allocs - lastAllocs) / n << "/tick)";
+        }
+        std::cout << " | ms p50 " << tickMs[n / 2] << ", p95 " << tickMs[n * 95 / 100]
+            << ", p99 " << tickMs[n * 99 / 100] << ", max " << tickMs[n - 1] << std::endl;
+
+        lastAllocs = allocs;
+        tickMs.clear();
+    }
+};
+
+// Runs the bot without a window, as fast as the simulation goes.
+void runHeadless(Bot& bot, long maxTicks, SoakLog& soak, TelemetrySampler& telemetry) {
+    initGame();
+    gameState = PLAYING;
+    double perfMs = 1000.0 / SDL_GetPerformanceFrequency();
+    for (long t = 0; maxTicks <= 0 || t < maxTicks; t++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        PlayerInput input = bot.think();
+        simulateTick(&input);
+        double ms = (SDL_GetPerformanceCounter() - start) * perfMs;
+        soak.addTick(ms);
+        telemetry.sample(ms, ms);
+    }
+}
+
+// --- Batch Simulation ---
+
+// Bot games by the thousand, for tuning Balance. Worlds are stepped in
+// lockstep BATCH_LANES at a time, one SIMD lane per world, and the batches are
+// spread over a WorkerPool. Each world has its own RNG seed and its own bot.
+//
+// A world plays by the game's rules through the game's functions: rollEnemy()
+// spawns, stepEnemy() moves, hitsHead() and blocksEnemy() resolve heads and
+// gloves, moveArms() and inSmashBox() run the punch, startPunch() locks on and
+// a Bot per world aims. Only the enemy step and the head and glove tests, the
+// bulk of a tick, have their own SSE2 form; it does stepEnemy()'s and
+// sweptCircleHit()'s arithmetic in the same order, so every lane comes out as
+// the scalar path would. Left out is everything that only shows, and the
+// pause on the game over screen: a lost game starts the next one right away.
+// Effects draw from the game's RNG, so a world and a game seeded alike part
+// ways at the first kill or block; their statistics agree. --batch-check
+// verifies both.
+
+const int BATCH_LANES = 4;
+const int BATCH_MAX_ENEMIES = 48; // Per world; spawns beyond this are dropped and counted
+
+struct BatchStats {
+    long games = 0;         // Finished games
+    long worldTicks = 0;
+    long kills = 0;
+    long smashes = 0;
+    long blocks = 0;
+    long headHits = 0;
+    long droppedSpawns = 0;
+    long reachedLevel[5] = {}; // Finished games that got to each level
+    std::vector<int> scores;   // Of every finished game
+    std::vector<int> lengths;  // In ticks
+
+    void merge(const BatchStats& o) {
+        games += o.games;
+        worldTicks += o.worldTicks;
+        kills += o.kills;
+        smashes += o.smashes;
+        blocks += o.blocks;
+        headHits += o.headHits;
+        droppedSpawns += o.droppedSpawns;
+        for (int i = 0; i < 5; i++) reachedLevel[i] += o.reachedLevel[i];
+        scores.insert(scores.end(), o.scores.begin(), o.scores.end());
+        lengths.insert(lengths.end(), o.lengths.begin(), o.lengths.end());
+    }
+
+    bool sameAs(const BatchStats& o) const {
+        return games == o.games && worldTicks == o.worldTicks && kills == o.kills && smashes == o.smashes
+            && blocks == o.blocks && headHits == o.headHits && droppedSpawns == o.droppedSpawns
+            && std::equal(reachedLevel, reachedLevel + 5, o.reachedLevel) && scores == o.scores && lengths == o.lengths;
+    }
+
+    double scoreMean() const {
+        double sum = 0;
+        for (int v : scores) sum += v;
+        return games ? sum / games : 0;
+    }
+
+    double lengthMean() const {
+        double sum = 0;
+        for (int v : lengths) sum += v;
+        return games ? sum / games : 0;
+    }
+
+    double perMinute(long count) const {
+        return worldTicks ? count * 3600.0 / worldTicks : 0;
+    }
+};
+
+// BATCH_LANES worlds in SoA form: every array has one entry per world, and
+// the enemy arrays one row of those per slot, so a row loads as one vector.
+// The enemy fields are Enemy's, less the ones only drawing reads. Slots are
+// reused; `id` tells a new enemy from the one before it.
+struct WorldBatch {
+    float x[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float y[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float prevX[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float prevY[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float vx[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float speed[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float size[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float swaySpeed[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float swayOffset[BATCH_MAX_ENEMIES][BATCH_LANES];
+    float swayAmplitude[BATCH_MAX_ENEMIES][BATCH_LANES];
+    Sint32 alive[BATCH_MAX_ENEMIES][BATCH_LANES]; // All bits set, or 0 for a free slot
+    Uint32 id[BATCH_MAX_ENEMIES][BATCH_LANES];
+    // Killed by a smash since the world last stepped. The game only erases
+    // those at its next step, and until then its bot can still find them.
+    bool smashed[BATCH_MAX_ENEMIES][BATCH_LANES];
+    int slotCount = 0; // Rows in use by any world
+
+    // Game: the globals of the same names, per world
+    int score[BATCH_LANES], level[BATCH_LANES], hitStop[BATCH_LANES];
+    long frames[BATCH_LANES];
+    float health[BATCH_LANES];
+    Uint32 random[BATCH_LANES];
+    Uint32 nextEnemyId[BATCH_LANES];
+    long gameTicks[BATCH_LANES];
+    Player player[BATCH_LANES];
+    Bot bot[BATCH_LANES];
+    int targetSlot[BATCH_LANES]; // Where bot[l]'s target is, or -1
+    bool restarted[BATCH_LANES]; // By the click on the game over screen, which is the first tick's input
+
+    int worlds = BATCH_LANES;  // Lanes that play, from lane 0
+    bool simd = true;          // Whether SSE2 builds step with stepEnemiesSse2()
+    std::vector<Enemy> list;   // One world's enemies as the game holds them, see gather()
+    TrajectoryPredictor prediction;
+    BatchStats stats;
+
+    void start(int lane, Uint32 seed, const Bot& style) {
+        random[lane] = seed ? seed : 0x9E3779B9u;
+        nextEnemyId[lane] = 1;
+        hitStop[lane] = 0; // Like the global, not reset between games
+        player[lane] = Player();
+        bot[lane] = style;
+        bot[lane].random = seed * 2654435761u + 1; // As --seed seeds the bot
+        bot[lane].aimX = WINDOW_WIDTH / 2.0f;
+        bot[lane].aimY = WINDOW_HEIGHT / 2.0f;
+        newGame(lane);
+        restarted[lane] = false; // runHeadless() starts the first game without one
+    }
+
+    // initGame() for one world.
+    void newGame(int lane) {
+        for (int s = 0; s < slotCount; s++) alive[s][lane] = smashed[s][lane] = 0;
+        score[lane] = 0;
+        health[lane] = 100;
+        level[lane] = 1;
+        frames[lane] = 0;
+        gameTicks[lane] = 0;
+        resetPlayer(player[lane]);
+        targetSlot[lane] = -1;
+    }
+
+    void endGame(int lane) {
+        stats.games++;
+        stats.scores.push_back(score[lane]);
+        stats.lengths.push_back((int)gameTicks[lane]);
+        for (int l = 1; l <= level[lane]; l++) stats.reachedLevel[l]++;
+        newGame(lane);
+        restarted[lane] = true;
+    }
+
+    // spawnEnemy() for one world.
+    void spawn(int lane) {
+        Enemy e = rollEnemy(random[lane], score[lane]);
+        int slot = 0;
+        while (slot < BATCH_MAX_ENEMIES && alive[slot][lane]) slot++;
+        if (slot == BATCH_MAX_ENEMIES) {
+            stats.droppedSpawns++;
+            return;
+        }
+        if (slot >= slotCount) {
+            // Fresh row: the other worlds have nothing in it
+            for (int l = 0; l < BATCH_LANES; l++) alive[slot][l] = smashed[slot][l] = 0;
+            slotCount = slot + 1;
+        }
+        e.id = nextEnemyId[lane]++;
+        store(slot, lane, e);
+    }
+
+    Enemy enemyAt(int slot, int lane) const {
+        Enemy e = {};
+        e.id = id[slot][lane];
+        e.x = x[slot][lane];
+        e.y = y[slot][lane];
+        e.prevX = prevX[slot][lane];
+        e.prevY = prevY[slot][lane];
+        e.size = size[slot][lane];
+        e.speed = speed[slot][lane];
+        e.vx = vx[slot][lane];
+        e.swayOffset = swayOffset[slot][lane];
+        e.swaySpeed = swaySpeed[slot][lane];
+        e.swayAmplitude = swayAmplitude[slot][lane];
+        e.active = alive[slot][lane] != 0;
+        e.steppedFrame = frames[lane];
+        return e;
+    }
+
+    void store(int slot, int lane, const Enemy& e) {
+        id[slot][lane] = e.id;
+        x[slot][lane] = e.x;
+        y[slot][lane] = e.y;
+        prevX[slot][lane] = e.prevX;
+        prevY[slot][lane] = e.prevY;
+        size[slot][lane] = e.size;
+        speed[slot][lane] = e.speed;
+        vx[slot][lane] = e.vx;
+        swayOffset[slot][lane] = e.swayOffset;
+        swaySpeed[slot][lane] = e.swaySpeed;
+        swayAmplitude[slot][lane] = e.swayAmplitude;
+        alive[slot][lane] = e.active ? -1 : 0;
+    }
+
+    int findSlot(int lane, Uint32 enemyId) const {
+        for (int s = 0; s < slotCount; s++) {
+            if ((alive[s][lane] || smashed[s][lane]) && id[s][lane] == enemyId) return s;
+        }
+        return -1;
+    }
+
+    // One world's enemies in spawn order, as `enemies` holds them, for the
+    // code that takes an enemy list.
+    const std::vector<Enemy>& gather(int lane) {
+        list.clear();
+        for (int s = 0; s < slotCount; s++) {
+            if (alive[s][lane]) list.push_back(enemyAt(s, lane));
+        }
+        std::sort(list.begin(), list.end(), [](const Enemy& a, const Enemy& b) { return a.id < b.id; });
+        return list;
+    }
+
+    // Bot::think() and triggerPunch() for one world.
+    void think(int lane) {
+        Bot& b = bot[lane];
+        Player& p = player[lane];
+        if (restarted[lane]) {
+            restarted[lane] = false;
+            p.input = { (Sint16)b.aimX, (Sint16)b.aimY, false };
+            return;
+        }
+
+        // findEnemy()
+        int t = targetSlot[lane];
+        if (t >= 0 && (b.targetId == 0 || !(alive[t][lane] || smashed[t][lane]) || id[t][lane] != b.targetId)) t = -1;
+        if (t < 0) {
+            const Enemy* chosen = b.chooseTarget(gather(lane), frames[lane], level[lane], prediction);
+            b.retarget(chosen);
+            t = chosen ? findSlot(lane, chosen->id) : -1;
+        }
+        targetSlot[lane] = t;
+
+        Enemy target = {};
+        if (t >= 0) target = enemyAt(t, lane);
+        bool click = b.steer(t >= 0 ? &target : nullptr, p.punchState == IDLE);
+        p.input = { (Sint16)b.aimX, (Sint16)b.aimY, click };
+        if (click && p.punchState == IDLE) startPunch(p, gather(lane), frames[lane], level[lane], prediction);
+    }
+
+    // update()'s enemy loop for every stepping world: moves each enemy with
+    // stepEnemy() and resolves heads, gloves and the ground. Counts head hits
+    // and blocks per world.
+    void stepEnemies(const Sint32* stepping, int* hits, int* blocks) {
+        for (int l = 0; l < BATCH_LANES; l++) {
+            hits[l] = blocks[l] = 0;
+            if (!stepping[l]) continue;
+            for (int s = 0; s < slotCount; s++) {
+                if (!alive[s][l]) continue;
+                Enemy e = enemyAt(s, l);
+                stepEnemy(e, frames[l]);
+                Vec2 from = { e.prevX, e.prevY };
+                Vec2 to = { e.x, e.y };
+                bool hit = hitsHead(player[l], from, to, e.size);
+                bool blocked = blocksEnemy(player[l], level[l], from, to, e.size);
+                if (hit || blocked || e.y > WINDOW_HEIGHT + e.size / 2) e.active = false;
+                store(s, l, e);
+                hits[l] += hit;
+                blocks[l] += blocked;
+            }
+        }
+    }
+
+#ifdef SMASH_SSE2
+    // sweptCircleHit() for four worlds.
+    static __m128 sweptCircleHit4(__m128 p0x, __m128 p0y, __m128 p1x, __m128 p1y, __m128 c0x, __m128 c0y, __m128 c1x, __m128 c1y, __m128 r) {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 ax = _mm_sub_ps(p0x, c0x), ay = _mm_sub_ps(p0y, c0y);
+        __m128 dx = _mm_sub_ps(_mm_sub_ps(p1x, c1x), ax), dy = _mm_sub_ps(_mm_sub_ps(p1y, c1y), ay);
+        __m128 len2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 along = _mm_xor_ps(_mm_add_ps(_mm_mul_ps(ax, dx), _mm_mul_ps(ay, dy)), signMask);
+        __m128 t = _mm_min_ps(_mm_max_ps(_mm_div_ps(along, len2), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        t = _mm_and_ps(_mm_cmpgt_ps(len2, _mm_setzero_ps()), t);
+        __m128 cx = _mm_add_ps(ax, _mm_mul_ps(dx, t)), cy = _mm_add_ps(ay, _mm_mul_ps(dy, t));
+        return _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(r, r));
+    }
+
+    // stepEnemies() four worlds at a time, with hitsHead()'s and
+    // blocksEnemy()'s circles gathered per world. Only the sway's sine is
+    // taken lane by lane, with std::sin as in stepEnemy().
+    void stepEnemiesSse2(const Sint32* stepping, int* hits, int* blocks) {
+        float headX[BATCH_LANES], headY[BATCH_LANES], headR[BATCH_LANES], gloveR[BATCH_LANES];
+        float leftX0[BATCH_LANES], leftY0[BATCH_LANES], leftX1[BATCH_LANES], leftY1[BATCH_LANES];
+        float rightX0[BATCH_LANES], rightY0[BATCH_LANES], rightX1[BATCH_LANES], rightY1[BATCH_LANES];
+        Sint32 canBlock[BATCH_LANES];
+        for (int l = 0; l < BATCH_LANES; l++) {
+            const Player& p = player[l];
+            headX[l] = p.x;
+            headY[l] = p.y - p.height;
+            headR[l] = p.width / 2;
+            gloveR[l] = 30.0f * levelScale(level[l]);
+            leftX0[l] = p.leftArmPrev.x;
+            leftY0[l] = p.leftArmPrev.y;
+            leftX1[l] = p.leftArm.x;
+            leftY1[l] = p.leftArm.y;
+            rightX0[l] = p.rightArmPrev.x;
+            rightY0[l] = p.rightArmPrev.y;
+            rightX1[l] = p.rightArm.x;
+            rightY1[l] = p.rightArm.y;
+            canBlock[l] = p.punchState == IDLE ? -1 : 0;
+        }
+        __m128 step = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)stepping));
+        __m128 hx = _mm_loadu_ps(headX), hy = _mm_loadu_ps(headY), hr = _mm_loadu_ps(headR), gr = _mm_loadu_ps(gloveR);
+        __m128 lx0 = _mm_loadu_ps(leftX0), ly0 = _mm_loadu_ps(leftY0), lx1 = _mm_loadu_ps(leftX1), ly1 = _mm_loadu_ps(leftY1);
+        __m128 rx0 = _mm_loadu_ps(rightX0), ry0 = _mm_loadu_ps(rightY0), rx1 = _mm_loadu_ps(rightX1), ry1 = _mm_loadu_ps(rightY1);
+        __m128 idle = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)canBlock));
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 minusOne = _mm_set1_ps(-1.0f);
+        const __m128 width = _mm_set1_ps((float)WINDOW_WIDTH);
+        const __m128 ground = _mm_set1_ps((float)WINDOW_HEIGHT);
+        __m128i hitCount = _mm_setzero_si128(), blockCount = _mm_setzero_si128();
+        for (int s = 0; s < slotCount; s++) {
+            __m128i live = _mm_loadu_si128((const __m128i*)alive[s]);
+            __m128 moving = _mm_and_ps(_mm_castsi128_ps(live), step);
+            int movingMask = _mm_movemask_ps(moving);
+            if (movingMask == 0) continue;
+
+            float wind[BATCH_LANES];
+            for (int l = 0; l < BATCH_LANES; l++) {
+                wind[l] = ((movingMask >> l) & 1) ? std::sin(frames[l] * swaySpeed[s][l] + swayOffset[s][l]) * swayAmplitude[s][l] : 0;
+            }
+            __m128 ex = _mm_loadu_ps(x[s]);
+            __m128 ey = _mm_loadu_ps(y[s]);
+            __m128 evx = _mm_loadu_ps(vx[s]);
+            __m128 margin = _mm_mul_ps(_mm_loadu_ps(size[s]), half); // size / 2, exactly
+            __m128 ny = _mm_add_ps(ey, _mm_loadu_ps(speed[s]));
+            __m128 nx = _mm_add_ps(ex, _mm_add_ps(evx, _mm_loadu_ps(wind)));
+            __m128 wall = _mm_cmplt_ps(nx, margin);
+            nx = select4(wall, margin, nx);
+            __m128 nvx = select4(wall, _mm_mul_ps(evx, minusOne), evx);
+            __m128 right = _mm_sub_ps(width, margin);
+            wall = _mm_cmpgt_ps(nx, right);
+            nx = select4(wall, right, nx);
+            nvx = select4(wall, _mm_mul_ps(nvx, minusOne), nvx);
+            _mm_storeu_ps(prevX[s], select4(moving, ex, _mm_loadu_ps(prevX[s])));
+            _mm_storeu_ps(prevY[s], select4(moving, ey, _mm_loadu_ps(prevY[s])));
+            _mm_storeu_ps(x[s], select4(moving, nx, ex));
+            _mm_storeu_ps(y[s], select4(moving, ny, ey));
+            _mm_storeu_ps(vx[s], select4(moving, nvx, evx));
+
+            __m128 hit = _mm_and_ps(moving, sweptCircleHit4(ex, ey, nx, ny, hx, hy, hx, hy, _mm_add_ps(margin, hr)));
+            __m128 gloveReach = _mm_add_ps(margin, gr);
+            __m128 blocked = _mm_or_ps(sweptCircleHit4(ex, ey, nx, ny, lx0, ly0, lx1, ly1, gloveReach),
+                sweptCircleHit4(ex, ey, nx, ny, rx0, ry0, rx1, ry1, gloveReach));
+            blocked = _mm_and_ps(_mm_and_ps(blocked, idle), moving);
+            __m128 landed = _mm_and_ps(moving, _mm_cmpgt_ps(ny, _mm_add_ps(ground, margin)));
+
+            __m128i gone = _mm_castps_si128(_mm_or_ps(_mm_or_ps(hit, blocked), landed));
+            _mm_storeu_si128((__m128i*)alive[s], _mm_andnot_si128(gone, live));
+            hitCount = _mm_sub_epi32(hitCount, _mm_castps_si128(hit));
+            blockCount = _mm_sub_epi32(blockCount, _mm_castps_si128(blocked));
+        }
+        _mm_storeu_si128((__m128i*)hits, hitCount);
+        _mm_storeu_si128((__m128i*)blocks, blockCount);
+    }
+#endif
+
+    // checkCollision() for one world, without the effects.
+    void smash(int lane, const SmashBox& box) {
+        for (int s = 0; s < slotCount; s++) {
+            if (!alive[s][lane]) continue;
+            if (!inSmashBox(box, { prevX[s][lane], prevY[s][lane] }, { x[s][lane], y[s][lane] })) continue;
+            alive[s][lane] = 0;
+            smashed[s][lane] = true;
+            score[lane] += smashPoints(box, size[s][lane]);
+            stats.kills++;
+            if (level[lane] >= 2) hitStop[lane] = SMASH_HIT_STOP;
+        }
+    }
+
+    // One tick of every world, in simulateTick()'s and update()'s order: bot
+    // and punch, then spawns, enemies and the arms.
+    void tick() {
+        Sint32 stepping[BATCH_LANES] = {};
+        for (int l = 0; l < worlds; l++) {
+            think(l);
+            stats.worldTicks++;
+            gameTicks[l]++;
+            if (hitStop[l] > 0) {
+                hitStop[l]--;
+                continue;
+            }
+            stepping[l] = -1;
+            for (int s = 0; s < slotCount; s++) smashed[s][l] = false;
+            frames[l]++;
+            level[l] = std::max(level[l], levelFor(score[l]));
+            placePlayer(player[l]);
+            if (frames[l] % spawnIntervalFor(score[l]) == 0) spawn(l);
+        }
+
+        int hits[BATCH_LANES], blocks[BATCH_LANES];
+#ifdef SMASH_SSE2
+        if (simd) stepEnemiesSse2(stepping, hits, blocks);
+        else stepEnemies(stepping, hits, blocks);
+#else
+        stepEnemies(stepping, hits, blocks);
+#endif
+
+        for (int l = 0; l < worlds; l++) {
+            if (!stepping[l]) continue;
+            health[l] -= HEAD_HIT_DAMAGE * hits[l];
+            score[l] += BLOCK_POINTS * blocks[l];
+            stats.headHits += hits[l];
+            stats.blocks += blocks[l];
+
+            ArmsTick arms = moveArms(player[l], frames[l], level[l]);
+            if (arms.smashing) smash(l, arms.box);
+            if (arms.smashEnded) stats.smashes++;
+            if (health[l] <= 0) endGame(l);
+        }
+
+        while (slotCount > 0) {
+            const Sint32* row = alive[slotCount - 1];
+            const bool* dead = smashed[slotCount - 1];
+            if (row[0] | row[1] | row[2] | row[3] | dead[0] | dead[1] | dead[2] | dead[3]) break;
+            slotCount--;
+        }
+    }
+};
+
+struct BatchJob {
+    WorldBatch* batch;
+    long ticks;
+};
+
+void runBatchJob(void* ctx) {
+    BatchJob& job = *static_cast<BatchJob*>(ctx);
+    for (long t = 0; t < job.ticks; t++) job.batch->tick();
+}
+
+// Neighbouring seeds would start out correlated.
+Uint32 worldSeed(Uint32 seed, int world) {
+    return (seed ^ (Uint32)world * 0x9E3779B9u) * 2654435761u + (Uint32)world;
+}
+
+// Runs `worldCount` worlds for `ticks` ticks each on `threads` threads and
+// sums up their games, in the same order for any thread count. `seconds`
+// gets the time it took.
+BatchStats simulateBatch(int worldCount, long ticks, Uint32 seed, int threads, const Bot& style, bool simd, double& seconds) {
+    int batchCount = (worldCount + BATCH_LANES - 1) / BATCH_LANES;
+    std::vector<WorldBatch> batches(batchCount);
+    std::vector<BatchJob> contexts(batchCount);
+    std::vector<Job> jobs(batchCount);
+    for (int b = 0; b < batchCount; b++) {
+        // Every lane starts, so the SSE2 step reads settled state, but only `worlds` play
+        for (int l = 0; l < BATCH_LANES; l++) batches[b].start(l, worldSeed(seed, b * BATCH_LANES + l), style);
+        batches[b].worlds = std::min(BATCH_LANES, worldCount - b * BATCH_LANES);
+        batches[b].simd = simd;
+        contexts[b] = { &batches[b], ticks };
+        jobs[b] = { runBatchJob, &contexts[b] };
+    }
+
+    WorkerPool pool;
+    pool.start(std::max(0, threads - 1));
+    Uint64 start = SDL_GetPerformanceCounter();
+    pool.run(jobs.data(), batchCount);
+    seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    pool.stop();
+
+    BatchStats total;
+    for (const WorldBatch& b : batches) total.merge(b.stats);
+    return total;
+}
+
+// Prints what `worldCount` worlds of `ticks` ticks each came to.
+void runBatch(int worldCount, long ticks, Uint32 seed, int threads, const Bot& style) {
+    double seconds = 0;
+    BatchStats total = simulateBatch(worldCount, ticks, seed, threads, style, true, seconds);
+
+    std::cout << "[batch] " << worldCount << " worlds x " << ticks << " ticks on " << std::max(1, threads)
+        << " threads: " << seconds << " s, " << total.worldTicks / std::max(seconds, 1e-9) / 1e6 << "M world-ticks/s" << std::endl;
+    std::cout << "[batch] balance: spawn every " << balance.spawnInterval << " ticks, -1 per " << balance.spawnScoreStep
+        << " points, min " << balance.spawnIntervalMin << "; speed +1 per " << balance.speedBonusScore << " points, max +"
+        << balance.speedBonusMax << "; level every " << balance.levelScore << " points" << std::endl;
+    if (total.games == 0) {
+        std::cout << "[batch] no game finished; run more ticks" << std::endl;
+        return;
+    }
+
+    std::vector<int>& s = total.scores;
+    std::sort(s.begin(), s.end());
+    long n = total.games;
+    std::cout << "[batch] " << n << " games | score mean " << total.scoreMean() << ", p10 " << s[n / 10] << ", p50 " << s[n / 2]
+        << ", p90 " << s[n * 9 / 10] << ", max " << s[n - 1] << " | length mean " << total.lengthMean() / 60 << " s" << std::endl;
+    std::cout << "[batch] reached level";
+    for (int l = 2; l <= 4; l++) std::cout << " " << l << ": " << 100.0 * total.reachedLevel[l] / n << "%";
+    std::cout << " | per minute: kills " << total.perMinute(total.kills) << ", smashes " << total.perMinute(total.smashes)
+        << ", blocks " << total.perMinute(total.blocks) << ", head hits " << total.perMinute(total.headHits);
+    if (total.droppedSpawns) std::cout << " | " << total.droppedSpawns << " spawns dropped";
+    std::cout << std::endl;
+}
+
+// runHeadless()'s loop for `ticks` ticks, with the games tallied the way a
+// world tallies them: a game runs from the click that starts it to the tick
+// that ends it, the game over screen not counted.
+BatchStats playGames(Bot bot, long ticks) {
+    BatchStats stats;
+    initGame();
+    gameState = PLAYING;
+    long length = 0;
+    for (long t = 0; t < ticks; t++) {
+        PlayerInput input = bot.think();
+        bool wasPlaying = gameState == PLAYING;
+        simulateTick(&input);
+        if (!wasPlaying && gameState != PLAYING) continue;
+
+        stats.worldTicks++;
+        length++;
+        stats.kills += tickEvents.kills;
+        stats.smashes += tickEvents.smashes;
+        stats.blocks += tickEvents.blocks;
+        stats.headHits += tickEvents.headHits;
+        if (gameState == GAME_OVER) {
+            stats.games++;
+            stats.scores.push_back(score);
+            stats.lengths.push_back((int)length);
+            for (int l = 1; l <= level; l++) stats.reachedLevel[l]++;
+            length = 0;
+        }
+    }
+    return stats;
+}
+
+// How far a world's averages may be from the game's for --batch-check. The
+// default 1200000 ticks come to about 500 games a side, after which chance
+// alone stays within about 6%.
+const double BATCH_CHECK_TOLERANCE = 0.10;
+
+// --batch-check: first, worlds stepped by the SSE2 and the scalar path must
+// finish the same games with the same scores. Then one world and the game,
+// seeded alike and played by the same bot for `ticks` ticks, must agree on
+// mean score, mean game length and kills per minute within the tolerance.
+// Returns the exit code: 0 if both hold.
+int runBatchCheck(long ticks, Uint32 seed, const Bot& style) {
+    bool pass = true;
+    double seconds = 0;
+#ifdef SMASH_SSE2
+    BatchStats sse2 = simulateBatch(8, 20000, seed, 1, style, true, seconds);
+    BatchStats scalar = simulateBatch(8, 20000, seed, 1, style, false, seconds);
+    bool same = sse2.sameAs(scalar);
+    pass = pass && same;
+    std::cout << "[batch-check] SSE2 and scalar step, 8 worlds x 20000 ticks: " << sse2.games << " and " << scalar.games
+        << " games, " << (same ? "identical: PASS" : "different: FAIL") << std::endl;
+#else
+    std::cout << "[batch-check] built without SSE2: only the scalar step to check" << std::endl;
+#endif
+
+    BatchStats world = simulateBatch(1, ticks, seed, 1, style, true, seconds);
+    Bot gameBot = style;
+    Uint32 gameSeed = worldSeed(seed, 0);
+    seedRandom(gameSeed);
+    gameBot.random = gameSeed * 2654435761u + 1;
+    gameBot.aimX = WINDOW_WIDTH / 2.0f;
+    gameBot.aimY = WINDOW_HEIGHT / 2.0f;
+    BatchStats game = playGames(gameBot, ticks);
+
+    std::cout << "[batch-check] one world against the game, " << ticks << " ticks: " << world.games << " and " << game.games
+        << " games (tolerance " << BATCH_CHECK_TOLERANCE * 100 << "%)" << std::endl;
+    if (world.games == 0 || game.games == 0) {
+        std::cout << "[batch-check] no game finished; run more ticks: FAIL" << std::endl;
+        return 1;
+    }
+    const char* names[] = { "score mean", "length mean (ticks)", "kills per minute" };
+    double worldValues[] = { world.scoreMean(), world.lengthMean(), world.perMinute(world.kills) };
+    double gameValues[] = { game.scoreMean(), game.lengthMean(), game.perMinute(game.kills) };
+    for (int i = 0; i < 3; i++) {
+        double off = worldValues[i] / std::max(gameValues[i], 1e-9) - 1;
+        bool ok = std::abs(off) <= BATCH_CHECK_TOLERANCE;
+        pass = pass && ok;
+        std::cout << "[batch-check]   " << names[i] << ": world " << worldValues[i] << ", game " << gameValues[i]
+            << " (" << (off >= 0 ? "+" : "") << off * 100 << "%) " << (ok ? "PASS" : "FAIL") << std::endl;
+    }
+    std::cout << "[batch-check] " << (pass ? "PASS" : "FAIL") << std::endl;
+    return pass ? 0 : 1;
+}
+
+// --- Render Backends ---
+
+// sdl: SDL's accelerated renderer. sdl-software: SDL's own software renderer,
+// to compare against. soft: our tiled rasterizer (SoftRaster.h), uploaded to
+// whatever renderer SDL can give us, for machines without a GPU.
+enum RenderBackend { BACKEND_SDL, BACKEND_SDL_SOFTWARE, BACKEND_SOFT };
+
+SDL_Renderer* createSdlRenderer(SDL_Window* window, RenderBackend backend, bool vsync) {
+    Uint32 flags = vsync ? SDL_RENDERER_PRESENTVSYNC : 0;
+    if (backend == BACKEND_SDL) flags |= SDL_RENDERER_ACCELERATED;
+    if (backend == BACKEND_SDL_SOFTWARE) flags |= SDL_RENDERER_SOFTWARE;
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, flags);
+    if (renderer) SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    return renderer;
+}
+
+void loadPlayerTexture(SDL_Renderer* renderer, Renderer& r) {
+    playerTexture = nullptr;
+    playerTextureId = 0;
+    SDL_Surface* image = SDL_LoadBMP("player.bmp");
+    if (!image) {
+        std::cout << "failed finding player.bmp" << std::endl;
+        return;
+    }
+    Uint32 colKey = SDL_MapRGB(image->format, 255, 0, 255);
+    SDL_SetColorKey(image, SDL_TRUE, colKey);
+
+    playerTexture = SDL_CreateTextureFromSurface(renderer, image);
+    if (playerTexture) playerTextureId = r.addTexture(playerTexture, image);
+    SDL_FreeSurface(image);
+}
+
+// --- Render Benchmark ---
+
+// Plays the same stretch of a bot game through each backend, vsync off, and
+// reports what recording, submitting and presenting a frame costs on each.
+void runRenderBench(SDL_Window* window, FrameRecorder& recorder, Bot bot, int frameCount) {
+    // Start from a busy screen
+    initGame();
+    gameState = PLAYING;
+    for (int t = 0; t < 600; t++) {
+        PlayerInput input = bot.think();
+        simulateTick(&input);
+    }
+    WorldState start;
+    start.capture();
+    int workers = recorder.pool.workerCount();
+
+    struct Config {
+        const char* name;
+        RenderBackend backend;
+        int threads;
+    };
+    const Config configs[] = {
+        { "sdl", BACKEND_SDL, workers },
+        { "sdl-software", BACKEND_SDL_SOFTWARE, workers },
+        { "soft", BACKEND_SOFT, 0 },
+        { "soft", BACKEND_SOFT, workers },
+    };
+    int configCount = workers > 0 ? 4 : 3; // Single-threaded soft once
+    for (int i = 0; i < configCount; i++) {
+        const Config& c = configs[i];
+        SDL_Renderer* sdlRenderer = createSdlRenderer(window, c.backend, false);
+        if (!sdlRenderer) {
+            std::cout << "[bench] " << c.name << ": unavailable: " << SDL_GetError() << std::endl;
+            continue;
+        }
+        recorder.pool.start(c.threads);
+        int w, h;
+        SDL_GetWindowSize(window, &w, &h);
+        Renderer r(sdlRenderer, w, h);
+        SoftRasterizer soft;
+        soft.setPool(&recorder.pool);
+        if (c.backend == BACKEND_SOFT) r.soft = &soft;
+        loadPlayerTexture(sdlRenderer, r);
+
+        start.restore();
+        Bot player = bot;
+        std::srand(1); // Same camera shake
+        double perfMs = 1000.0 / SDL_GetPerformanceFrequency();
+        double totalMs = 0, maxMs = 0, presentMs = 0;
+        for (int f = 0; f < frameCount; f++) {
+            SDL_PumpEvents();
+            PlayerInput input = player.think();
+            simulateTick(&input);
+
+            Uint64 frameStart = SDL_GetPerformanceCounter();
+            render(r, recorder);
+            r.submit();
+            Uint64 presentStart = SDL_GetPerformanceCounter();
+            SDL_RenderPresent(sdlRenderer);
+            Uint64 end = SDL_GetPerformanceCounter();
+
+            double ms = (end - frameStart) * perfMs;
+            totalMs += ms;
+            maxMs = std::max(maxMs, ms);
+            presentMs += (end - presentStart) * perfMs;
+        }
+
+        SDL_RendererInfo info;
+        SDL_GetRendererInfo(sdlRenderer, &info);
+        std::cout << "[bench] " << c.name << " (" << info.name << ", " << c.threads << " worker threads): frame "
+            << totalMs / frameCount << " ms avg, " << maxMs << " ms max, present " << presentMs / frameCount << " ms avg"
+            << " | " << w << "x" << h << ", " << frameCount << " frames" << std::endl;
+        SDL_DestroyRenderer(sdlRenderer); // Takes its textures with it
+        playerTexture = nullptr;
+    }
+    recorder.pool.start(workers);
+}
+
+// --- Main ---
+
+int main(int argc, char* argv[]) {
+    std::srand(std::time(nullptr));
+    seedRandom((Uint32)std::time(nullptr));
+
+    Profiler profiler;
+    FrameRecorder recorder;
+    ResolutionScaler scaler;
+    int loopbackDelay = -1;
+    Bot bot;
+    bool useBot = false;
+    bool headless = false;
+    long maxTicks = 0;
+    SoakLog soak;
+    std::string capturePath;
+    int captureBuffers = 8;
+    bool useAudio = true;
+    const char* audioDriver = nullptr;
+    int audioBuffer = 512;
+    static TelemetrySampler telemetry; // Its record queue is far too big for the stack
+    const char* telemetryPath = nullptr;
+    RenderBackend backend = BACKEND_SDL;
+    int benchFrames = 0;
+    int renderThreads = std::min(3, (int)std::thread::hardware_concurrency() - 1);
+    Uint32 seed = (Uint32)std::time(nullptr);
+    int batchWorlds = 0;
+    bool batchCheck = false;
+    int batchThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--stats") == 0) profiler.enabled = true;
+        if (std::strcmp(argv[i], "--render-threads") == 0 && i + 1 < argc) renderThreads = std::atoi(argv[++i]);
+        if (std::strcmp(argv[i], "--verify-render") == 0) recorder.verify = true;
+        if (std::strcmp(argv[i], "--target-preview") == 0) targetPreview = true;
+        if (std::strcmp(argv[i], "--no-sim-lod") == 0) simLod = false;
+        if (std::strcmp(argv[i], "--renderer") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "soft") == 0) backend = BACKEND_SOFT;
+            else if (std::strcmp(name, "sdl-software") == 0) backend = BACKEND_SDL_SOFTWARE;
+            else backend = BACKEND_SDL;
+        }
+        if (std::strcmp(argv[i], "--render-bench") == 0 && i + 1 < argc) benchFrames = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--loopback-delay") == 0 && i + 1 < argc) loopbackDelay = std::atoi(argv[++i]);
+        if (std::strcmp(argv[i], "--bot") == 0 && i + 1 < argc) {
+            const char* preset = argv[++i];
+            useBot = true;
+            if (std::strcmp(preset, "easy") == 0) bot.setDifficulty(BOT_EASY);
+            else if (std::strcmp(preset, "hard") == 0) bot.setDifficulty(BOT_HARD);
+            else bot.setDifficulty(BOT_NORMAL);
+        }
+        if (std::strcmp(argv[i], "--headless") == 0) headless = true;
+        if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batchWorlds = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--batch-check") == 0) batchCheck = true;
+        if (std::strcmp(argv[i], "--batch-threads") == 0 && i + 1 < argc) batchThreads = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--spawn-interval") == 0 && i + 1 < argc) balance.spawnInterval = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--spawn-interval-min") == 0 && i + 1 < argc) balance.spawnIntervalMin = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--spawn-score-step") == 0 && i + 1 < argc) balance.spawnScoreStep = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--speed-bonus-max") == 0 && i + 1 < argc) balance.speedBonusMax = std::max(0.0f, (float)std::atof(argv[++i]));
+        if (std::strcmp(argv[i], "--speed-bonus-score") == 0 && i + 1 < argc) balance.speedBonusScore = std::max(1.0f, (float)std::atof(argv[++i]));
+        if (std::strcmp(argv[i], "--level-score") == 0 && i + 1 < argc) balance.levelScore = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) capturePath = argv[++i];
+        if (std::strcmp(argv[i], "--capture-buffers") == 0 && i + 1 < argc) captureBuffers = std::atoi(argv[++i]);
+        if (std::strcmp(argv[i], "--no-audio") == 0) useAudio = false;
+        if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) telemetryPath = argv[++i];
+        if (std::strcmp(argv[i], "--telemetry-csv") == 0 && i + 2 < argc) {
+            // Offline: convert a recorded file and exit
+            bool ok = telemetryToCsv(argv[i + 1], argv[i + 2]);
+            if (!ok) std::cerr << "Cannot convert " << argv[i + 1] << " to " << argv[i + 2] << std::endl;
+            return ok ? 0 : 1;
+        }
+        if (std::strcmp(argv[i], "--audio-driver") == 0 && i + 1 < argc) audioDriver = argv[++i];
+        if (std::strcmp(argv[i], "--audio-buffer") == 0 && i + 1 < argc) audioBuffer = std::max(64, std::min(8192, std::atoi(argv[++i])));
+        if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) maxTicks = std::atol(argv[++i]);
+        if (std::strcmp(argv[i], "--soak-interval") == 0 && i + 1 < argc) soak.interval = std::max(1, std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (Uint32)std::strtoul(argv[++i], nullptr, 10);
+            seedRandom(seed);
+            bot.random = seed * 2654435761u + 1;
+        }
+        if (std::strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc) {
+            // Fixed scale, no adaptation
+            scaler.enabled = false;
+            scaler.scale = std::min(1.0f, std::max(0.25f, (float)std::atof(argv[++i])));
+        }
+    }
+    soak.enabled = useBot || headless; // Headless runs always play the bot
+    bot.aimX = WINDOW_WIDTH / 2.0f;
+    bot.aimY = WINDOW_HEIGHT / 2.0f;
+
+    if (batchCheck) return runBatchCheck(maxTicks > 0 ? maxTicks : 1200000, seed, bot);
+    if (batchWorlds > 0) {
+        // Every world gets its own seed, derived from --seed
+        runBatch(batchWorlds, maxTicks > 0 ? maxTicks : 36000, seed, batchThreads, bot);
+        return 0;
+    }
+
+    if (telemetryPath && !telemetry.writer.start(telemetryPath)) {
+        std::cerr << "Cannot write telemetry to " << telemetryPath << std::endl;
+    }
+
+    if (headless) {
+        // Without a window there is nobody to play but the bot
+        runHeadless(bot, maxTicks, soak, telemetry);
+        telemetry.writer.stop();
+        if (telemetry.writer.dropped) std::cerr << "[telemetry] " << telemetry.writer.dropped << " records dropped" << std::endl;
+        return 0;
+    }
+    recorder.pool.start(std::max(0, renderThreads));
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        std::cerr << "SDL Init Failed: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    // Sound is optional: without a device the game just plays silently.
+    // --audio-driver dummy or disk runs the mixer without sound hardware.
+    if (useAudio) {
+        if (audioDriver) SDL_setenv("SDL_AUDIODRIVER", audioDriver, 1);
+        if (SDL_InitSubSystem(SDL_INIT_AUDIO) == 0) {
+            loadSounds(audio);
+            if (audio.open(nullptr, audioBuffer)) profiler.audio = &audio;
+            else std::cerr << "No audio device: " << SDL_GetError() << std::endl;
+        }
+        else {
+            std::cerr << "Audio Init Failed: " << SDL_GetError() << std::endl;
+        }
+    }
+
+    SDL_Window* window = SDL_CreateWindow("Smash Master - C++ SDL2",
+        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+        WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+
+    if (!window) return 1;
+
+    if (benchFrames > 0) {
+        Bot benchBot = bot;
+        benchBot.setDifficulty(BOT_HARD);
+        soundMuted = true;
+        runRenderBench(window, recorder, benchBot, benchFrames);
+        audio.close();
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 0;
+    }
+
+    SDL_Renderer* sdlRenderer = createSdlRenderer(window, backend, true);
+    if (!sdlRenderer) {
+        std::cerr << "Renderer Creation Failed: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    Renderer r(sdlRenderer, WINDOW_WIDTH, WINDOW_HEIGHT);
+    SoftRasterizer soft;
+    if (backend == BACKEND_SOFT) {
+        soft.setPool(&recorder.pool);
+        r.soft = &soft;
+        scaler.enabled = false; // Always draws at native size
+        scaler.scale = 1.0f;
+    }
+    r.renderScale = scaler.scale;
+    SDL_DisplayMode displayMode;
+    if (SDL_GetWindowDisplayMode(window, &displayMode) == 0 && displayMode.refresh_rate > 0) {
+        scaler.budgetMs = 1000.0 / displayMode.refresh_rate;
+    }
+    loadPlayerTexture(sdlRenderer, r);
+    bool running = true;
+    SDL_Event event;
+
+    // Two-player loopback: player 2 plays on the keyboard (arrows aim, space
+    // punches) but their input only reaches the simulation through a delayed
+    // queue, like a remote peer's would, and the session rolls back to apply it.
+    RollbackSession session;
+    DelayedInputQueue peer;
+    PlayerInput secondInput = { (Sint16)(WINDOW_WIDTH / 2), (Sint16)(WINDOW_HEIGHT / 2), false };
+    bool loopback = loopbackDelay >= 0;
+    if (loopback) {
+        playerCount = 2;
+        players[1].color = COL_ORANGE;
+        peer.delay = std::min(loopbackDelay, (int)RollbackSession::MAX_ROLLBACK);
+        profiler.rollback = &session;
+    }
+
+    // Recording for later review: every presented frame, as a QOI sequence or
+    // raw video (a path ending in .raw)
+    FrameCapture capture;
+    if (!capturePath.empty()) {
+        int outW, outH;
+        SDL_GetRendererOutputSize(sdlRenderer, &outW, &outH);
+        if (capture.start(capturePath, outW, outH, captureBuffers)) profiler.capture = &capture;
+        else std::cerr << "Cannot capture to " << capturePath << std::endl;
+    }
+    long presented = 0;
+
+    initGame();
+    gameState = PLAYING;
+
+    Uint64 perfFreq = SDL_GetPerformanceFrequency();
+    Uint64 lastFrame = SDL_GetPerformanceCounter();
+
+    while (running) {
+        // Input
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) running = false;
+            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
+                wakeEnemies(); // Skipped steps bounce off the walls they had
+                WINDOW_WIDTH = event.window.data1;
+                WINDOW_HEIGHT = event.window.data2;
+                r.screenW = WINDOW_WIDTH; r.screenH = WINDOW_HEIGHT;
+                for (int i = 0; i < playerCount; i++) players[i].y = WINDOW_HEIGHT - 100;
+            }
+            if (event.type == SDL_MOUSEMOTION) {
+                mouse.x = event.motion.x;
+                mouse.y = event.motion.y;
+            }
+            if (event.type == SDL_MOUSEBUTTONDOWN) {
+                mouse.clicked = true;
+            }
+            if (event.type == SDL_KEYDOWN && !event.key.repeat && event.key.keysym.scancode == SDL_SCANCODE_SPACE) {
+                secondInput.punch = true;
+            }
+        }
+
+        // Loop
+        Uint64 tickStart = SDL_GetPerformanceCounter();
+        PlayerInput local = { (Sint16)mouse.x, (Sint16)mouse.y, mouse.clicked };
+        mouse.clicked = false;
+        if (useBot) {
+            local = bot.think();
+            if (maxTicks > 0 && soak.ticks >= maxTicks) running = false;
+        }
+        if (loopback) {
+            const Uint8* keys = SDL_GetKeyboardState(NULL);
+            int aimX = secondInput.x + (keys[SDL_SCANCODE_RIGHT] - keys[SDL_SCANCODE_LEFT]) * 12;
+            int aimY = secondInput.y + (keys[SDL_SCANCODE_DOWN] - keys[SDL_SCANCODE_UP]) * 12;
+            secondInput.x = (Sint16)std::min(std::max(aimX, 0), WINDOW_WIDTH);
+            secondInput.y = (Sint16)std::min(std::max(aimY, 0), WINDOW_HEIGHT);
+            peer.push(session.tick, secondInput);
+            secondInput.punch = false;
+
+            long t;
+            PlayerInput remote;
+            while (peer.pop(session.tick, t, remote)) session.receive(t, remote);
+            session.advance(local);
+        }
+        else {
+            simulateTick(&local);
+        }
+        double tickMs = (SDL_GetPerformanceCounter() - tickStart) * 1000.0 / perfFreq;
+
+        // Draw
+        long allocsBefore = allocationCount();
+        render(r, recorder);
+
+        if (gameState == MENU) {
+            r.setLayer(LAYER_OVERLAY);
+            r.fillCircle(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2, 80, COL_RED_500);
+        }
+        if (gameState == GAME_OVER) {
+            r.setLayer(LAYER_OVERLAY);
+            // Darken
+            r.fillRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, { 0, 0, 0, 200 });
+
+            r.drawNumber(score, WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2, 60, COL_YELLOW_400);
+        }
+
+        r.submit();
+        long renderAllocs = allocsBefore < 0 ? -1 : allocationCount() - allocsBefore;
+        if (capture.active()) captureFrame(capture, sdlRenderer, presented);
+        SDL_RenderPresent(sdlRenderer);
+        presented++;
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        double frameMs = (now - lastFrame) * 1000.0 / perfFreq;
+        profiler.addFrame(frameMs, r, renderAllocs);
+        soak.addTick(frameMs);
+        telemetry.sample(tickMs, frameMs);
+        scaler.addFrame(frameMs);
+        r.renderScale = scaler.scale;
+        lastFrame = now;
+    }
+
+    if (capture.active()) {
+        capture.stop();
+        std::cout << "[capture] " << capture.written << " of " << presented << " frames written to " << capturePath
+            << ", " << capture.dropped << " dropped";
+        if (capture.failed) std::cout << ", " << capture.failed << " failed to write";
+        if (capture.captured) {
+            std::cout << " | read " << capture.readMs / capture.captured << " ms avg"
+                << ", encode " << capture.encodeMicros / 1000.0 / capture.captured << " ms avg";
+        }
+        if (capturePath.size() > 4 && capturePath.compare(capturePath.size() - 4, 4, ".raw") == 0) {
+            std::cout << " | rgba " << capture.width << "x" << capture.height;
+        }
+        std::cout << std::endl;
+    }
+
+    telemetry.writer.stop();
+    if (telemetry.writer.dropped) std::cerr << "[telemetry] " << telemetry.writer.dropped << " records dropped" << std::endl;
+
+    audio.close();
+    SDL_DestroyRenderer(sdlRenderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+
+    return 0;
 }
\ No newline at end of file